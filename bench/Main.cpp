@@ -0,0 +1,820 @@
+#include <modernui/ModernUI.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr size_t numIterations = 50u;
+constexpr size_t numSceneFrames = 200u;
+
+// Every heap allocation of the program, counted by the replaced global operator new below
+std::atomic<size_t> numAllocations{ 0u };
+
+// Results are also written as JSON, so that tools can compare runs of different versions
+struct Result final
+{
+  std::string name;
+  std::vector<std::pair<std::string, double>> metrics;
+};
+
+void writeJson(const std::string& path, const std::vector<Result>& results)
+{
+  std::ofstream file(path);
+  file.precision(9);
+  file << "{\n  \"results\": [";
+  for (size_t index = 0u; index < results.size(); ++index)
+  {
+    const Result& result = results[index];
+    file << (index > 0u ? ",\n" : "\n") << "    { \"name\": \"" << result.name << "\"";
+    for (const auto& metric : result.metrics)
+    {
+      file << ", \"" << metric.first << "\": " << metric.second;
+    }
+
+    file << " }";
+  }
+
+  file << "\n  ]\n}\n";
+}
+
+// Nearest rank of sorted values
+double getPercentile(const std::vector<double>& sortedValues, double percentile)
+{
+  const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * sortedValues.size()));
+  return sortedValues[std::min(std::max(rank, size_t(1u)), sortedValues.size()) - 1u];
+}
+
+// Returns the median construction time in milliseconds
+template<typename Construct>
+double measureConstruction(Construct construct)
+{
+  std::vector<double> times;
+  for (size_t iteration = 0u; iteration < numIterations; ++iteration)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    if (!construct())
+    {
+      return -1.0;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2u];
+}
+
+const char* getInstructionSetName(ModernUI::Context::InstructionSet set)
+{
+  if (set == ModernUI::Context::InstructionSet::AVX2)
+  {
+    return "AVX2";
+  }
+  else if (set == ModernUI::Context::InstructionSet::SSE2)
+  {
+    return "SSE2";
+  }
+
+  return "scalar";
+}
+
+// Returns the vertices generated per second by full frames of half windows and half buttons, which are either added
+// widgets or live in the context
+double measureVertexThroughput(const std::shared_ptr<const ModernUI::Font>& font,
+                               size_t numWidgets,
+                               ModernUI::Context::InstructionSet set,
+                               bool contextStorage,
+                               size_t numThreads = 1u)
+{
+  ModernUI::Context context(font);
+  context.setInstructionSet(set);
+  context.setNumThreads(numThreads);
+
+  std::vector<std::unique_ptr<ModernUI::Window>> windows;
+  std::vector<std::unique_ptr<ModernUI::Button>> buttons;
+  for (size_t index = 0u; index < numWidgets / 2u; ++index)
+  {
+    const int32_t x = static_cast<int32_t>(index % 100u) * 8;
+    const int32_t y = static_cast<int32_t>(index / 100u) * 8;
+
+    if (contextStorage)
+    {
+      context.createWindow(x, y, 64, 32);
+      context.createButton("Button", x, y, 64, 32);
+      continue;
+    }
+
+    windows.push_back(std::make_unique<ModernUI::Window>(x, y, 64, 32));
+    context.addWindow(*windows.back());
+
+    buttons.push_back(std::make_unique<ModernUI::Button>("Button", x, y, 64, 32));
+    context.addButton(*buttons.back());
+  }
+
+  // Warm up, so that the label caches are filled and the vectors have grown
+  context.processFrame();
+
+  size_t numVertices = 0u;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t iteration = 0u; iteration < numIterations; ++iteration)
+  {
+    context.processFrame();
+    numVertices += context.getNumColorVertices() + context.getNumTextureVertices();
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  return static_cast<double>(numVertices) / std::chrono::duration<double>(end - start).count();
+}
+
+// Returns the median time in milliseconds of frames that pan over a canvas of which about 5% is visible, either with
+// a viewport or without
+double measurePanning(const std::shared_ptr<const ModernUI::Font>& font, size_t numWidgets, bool cull)
+{
+  ModernUI::Context context(font);
+
+  // A square canvas of widgets spaced 80 by 40 pixels, with a viewport of 5% of its area
+  const int32_t columns = static_cast<int32_t>(std::sqrt(static_cast<double>(numWidgets / 2u))) + 1;
+  for (size_t index = 0u; index < numWidgets / 2u; ++index)
+  {
+    const int32_t x = static_cast<int32_t>(index % columns) * 80;
+    const int32_t y = static_cast<int32_t>(index / columns) * 40;
+    context.createWindow(x, y, 76, 36);
+    context.createButton("Cell", x + 4, y + 4, 68, 28);
+  }
+
+  const int32_t viewportWidth = static_cast<int32_t>(columns * 80 * std::sqrt(0.05));
+  const int32_t viewportHeight = static_cast<int32_t>(columns * 40 * std::sqrt(0.05));
+
+  std::vector<double> times;
+  for (size_t iteration = 0u; iteration < numIterations; ++iteration)
+  {
+    const int32_t offset = static_cast<int32_t>(iteration) * 16;
+    if (cull)
+    {
+      context.setViewport({ offset, offset, viewportWidth, viewportHeight });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    context.processFrame();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2u];
+}
+
+// Returns the average time in microseconds of finding the widget under a random point
+double measureHitTesting(const std::shared_ptr<const ModernUI::Font>& font, size_t numWidgets)
+{
+  ModernUI::Context context(font);
+
+  const int32_t columns = static_cast<int32_t>(std::sqrt(static_cast<double>(numWidgets / 2u))) + 1;
+  for (size_t index = 0u; index < numWidgets / 2u; ++index)
+  {
+    const int32_t x = static_cast<int32_t>(index % columns) * 80;
+    const int32_t y = static_cast<int32_t>(index / columns) * 40;
+    context.createWindow(x, y, 76, 36);
+    context.createButton("Cell", x + 4, y + 4, 68, 28);
+  }
+
+  // The first query builds the spatial index
+  context.findWidget(0, 0);
+
+  constexpr size_t numQueries = 100000u;
+  uint32_t seed = 1u;
+  size_t numHits = 0u;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t query = 0u; query < numQueries; ++query)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    const int32_t x = static_cast<int32_t>((seed >> 8u) % static_cast<uint32_t>(columns * 80));
+    const int32_t y = static_cast<int32_t>((seed >> 4u) % static_cast<uint32_t>(columns * 40));
+    numHits += context.findWidget(x, y).type != ModernUI::WidgetHandle::Type::None ? 1u : 0u;
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  return numHits > 0u ? std::chrono::duration<double, std::micro>(end - start).count() / numQueries : -1.0;
+}
+
+// Returns the median time in milliseconds of retained frames that drag a panel of buttons over a static background,
+// either moving only the panel that the buttons are children of or moving every button on its own
+double measureDragging(const std::shared_ptr<const ModernUI::Font>& font, size_t numChildren, bool parented)
+{
+  ModernUI::Context context(font);
+  context.setRetainedMode(true);
+
+  for (size_t index = 0u; index < 10000u; ++index)
+  {
+    context.createWindow(static_cast<int32_t>(index % 100u) * 20, static_cast<int32_t>(index / 100u) * 20, 16, 16);
+  }
+
+  const ModernUI::WindowHandle panel = context.createWindow(0, 0, 800, 800);
+  std::vector<ModernUI::ButtonHandle> children;
+  for (size_t index = 0u; index < numChildren; ++index)
+  {
+    const int32_t x = static_cast<int32_t>(index % 25u) * 32;
+    const int32_t y = static_cast<int32_t>(index / 25u) * 20;
+    children.push_back(context.createButton("Child", x, y, 30, 18));
+    if (parented)
+    {
+      context.setParent(children.back(), panel);
+    }
+  }
+
+  context.processFrame();
+
+  std::vector<double> times;
+  for (size_t iteration = 0u; iteration < numIterations; ++iteration)
+  {
+    const int32_t offset = static_cast<int32_t>(iteration % 64u) * 4;
+
+    const auto start = std::chrono::steady_clock::now();
+    context.setWindowPosition(panel, offset, offset);
+    if (!parented)
+    {
+      for (size_t index = 0u; index < numChildren; ++index)
+      {
+        const int32_t x = static_cast<int32_t>(index % 25u) * 32;
+        const int32_t y = static_cast<int32_t>(index / 25u) * 20;
+        context.setButtonPosition(children[index], offset + x, offset + y);
+      }
+    }
+
+    context.processFrame();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2u];
+}
+
+// Returns the median time in milliseconds of retained frames that edit one label in a column of rows of laid out
+// buttons, which only lays out the row of that button again. The labels keep their length and so their vertex range.
+double measureRelayout(const std::shared_ptr<const ModernUI::Font>& font, size_t numRows, size_t numColumns)
+{
+  ModernUI::Context context(font);
+  context.setRetainedMode(true);
+
+  const ModernUI::WindowHandle column = context.createWindow(0, 0, 0, 0);
+  context.setWindowLayout(column, ModernUI::Context::LayoutDirection::Column, 4, 2);
+
+  std::vector<ModernUI::ButtonHandle> buttons;
+  for (size_t rowIndex = 0u; rowIndex < numRows; ++rowIndex)
+  {
+    const ModernUI::WindowHandle row = context.createWindow(0, 0, 0, 0);
+    context.setParent(row, column);
+    context.setWindowLayout(row, ModernUI::Context::LayoutDirection::Row, 0, 2);
+    for (size_t columnIndex = 0u; columnIndex < numColumns; ++columnIndex)
+    {
+      buttons.push_back(context.createButton("Cell", 0, 0, 0, 0));
+      context.setParent(buttons.back(), row);
+    }
+  }
+
+  context.processFrame();
+
+  std::vector<double> times;
+  for (size_t iteration = 0u; iteration < numIterations; ++iteration)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    context.setButtonText(buttons[iteration * 7919u % buttons.size()], iteration % 2u ? "Cell" : "WWWW");
+    context.processFrame();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2u];
+}
+
+// Returns the median time in milliseconds of frames that draw layers of buttons on top of each other, like pages of
+// tabs, of which only the topmost one is visible. One of its buttons moves every frame, so what is hidden is found
+// again every frame.
+double measureStackedLayers(const std::shared_ptr<const ModernUI::Font>& font, size_t numLayers, bool occlusion)
+{
+  ModernUI::Context context(font);
+  context.setOcclusionCulling(occlusion);
+
+  ModernUI::ButtonHandle moving;
+  for (size_t layer = 0u; layer < numLayers; ++layer)
+  {
+    context.createWindow(0, 0, 1600, 1280);
+    for (size_t index = 0u; index < 1000u; ++index)
+    {
+      const int32_t x = static_cast<int32_t>(index % 25u) * 64;
+      const int32_t y = static_cast<int32_t>(index / 25u) * 32;
+      moving = context.createButton("Cell", x, y, 60, 30);
+    }
+  }
+
+  context.processFrame();
+
+  std::vector<double> times;
+  for (size_t iteration = 0u; iteration < numIterations; ++iteration)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    context.setButtonPosition(moving, 24 * 64 + static_cast<int32_t>(iteration % 2u), 39 * 32);
+    context.processFrame();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2u];
+}
+
+// Returns the median time in milliseconds of retained frames while producer threads keep queuing label and color
+// changes, and the number of changes they queued per second
+std::pair<double, double> measureQueuedUpdates(const std::shared_ptr<const ModernUI::Font>& font, size_t numProducers)
+{
+  ModernUI::Context context(font);
+  context.setRetainedMode(true);
+
+  std::vector<ModernUI::WindowHandle> windows;
+  std::vector<ModernUI::ButtonHandle> buttons;
+  for (size_t index = 0u; index < 1000u; ++index)
+  {
+    const int32_t x = static_cast<int32_t>(index % 25u) * 32;
+    const int32_t y = static_cast<int32_t>(index / 25u) * 20;
+    windows.push_back(context.createWindow(x, y, 30, 18));
+    buttons.push_back(context.createButton("Cell", x, y, 30, 18));
+  }
+
+  context.processFrame();
+
+  std::atomic<bool> stopping{ false };
+  std::atomic<size_t> numQueued{ 0u };
+  std::vector<std::thread> producers;
+  for (size_t producer = 0u; producer < numProducers; ++producer)
+  {
+    producers.emplace_back([&, producer]() {
+      for (size_t update = producer; !stopping.load(std::memory_order_relaxed); update += numProducers)
+      {
+        const size_t index = update * 7919u % buttons.size();
+        context.queueButtonText(buttons[index], update % 2u ? "Cell" : "WWWW");
+        context.queueWindowColor(windows[index], update % 2u ? 1.0f : 0.5f, 0.5f, 0.5f);
+        numQueued.fetch_add(2u, std::memory_order_relaxed);
+        std::this_thread::yield();
+      }
+    });
+  }
+
+  // Frames only start once every producer is running
+  while (numQueued.load() < numProducers * 2u)
+  {
+    std::this_thread::yield();
+  }
+
+  std::vector<double> times;
+  const size_t numQueuedBefore = numQueued.load();
+  const auto first = std::chrono::steady_clock::now();
+  for (size_t iteration = 0u; iteration < numIterations; ++iteration)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    context.processFrame();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+    // Stands in for presenting the frame, which gives the producers time to queue more changes
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Counts the changes queued while the frames ran, the last few of them are left for the next frame
+  const size_t numApplied = numQueued.load() - numQueuedBefore;
+  const auto last = std::chrono::steady_clock::now();
+  stopping = true;
+  for (std::thread& producer : producers)
+  {
+    producer.join();
+  }
+
+  std::sort(times.begin(), times.end());
+  return { times[times.size() / 2u], numApplied / std::chrono::duration<double>(last - first).count() };
+}
+
+enum class Scene
+{
+  Windows,
+  Buttons,
+  LongLabels
+};
+
+const char* getSceneName(Scene scene)
+{
+  if (scene == Scene::Windows)
+  {
+    return "windows";
+  }
+  else if (scene == Scene::Buttons)
+  {
+    return "buttons";
+  }
+
+  return "long labels";
+}
+
+struct SceneResult final
+{
+  double p50, p90, p99, max;
+  double verticesPerSecond;
+  double bytesPerFrame;
+  double allocationsPerFrame;
+};
+
+// Frames of a scene in which every widget moves, or only one in a hundred. Only processFrame() is measured, not the
+// setters that animate the scene.
+SceneResult measureScene(const std::shared_ptr<const ModernUI::Font>& font,
+                         Scene scene,
+                         size_t numWidgets,
+                         bool animated,
+                         bool retained)
+{
+  ModernUI::Context context(font);
+  context.setRetainedMode(retained);
+
+  const std::string text = scene == Scene::LongLabels ?
+                             "The quick brown fox jumps over the lazy dog while the band plays on" :
+                             "Button";
+  const int32_t columns = static_cast<int32_t>(std::sqrt(static_cast<double>(numWidgets))) + 1;
+
+  std::vector<ModernUI::WindowHandle> windows;
+  std::vector<ModernUI::ButtonHandle> buttons;
+  for (size_t index = 0u; index < numWidgets; ++index)
+  {
+    const int32_t x = static_cast<int32_t>(index % columns) * 80;
+    const int32_t y = static_cast<int32_t>(index / columns) * 40;
+    if (scene == Scene::Windows)
+    {
+      windows.push_back(context.createWindow(x, y, 76, 36));
+    }
+    else
+    {
+      buttons.push_back(context.createButton(text, x, y, 76, 36));
+    }
+  }
+
+  // Warm up, so that the label caches are filled and the vectors have grown
+  context.processFrame();
+  context.processFrame();
+
+  const size_t step = animated ? 1u : 100u;
+  std::vector<double> times;
+  size_t numVertices = 0u;
+  size_t numBytes = 0u;
+  size_t numFrameAllocations = 0u;
+  for (size_t frame = 0u; frame < numSceneFrames; ++frame)
+  {
+    const int32_t offset = frame % 2u ? 2 : 0;
+    for (size_t index = frame % step; index < numWidgets; index += step)
+    {
+      const int32_t x = static_cast<int32_t>(index % columns) * 80 + offset;
+      const int32_t y = static_cast<int32_t>(index / columns) * 40 + offset;
+      if (scene == Scene::Windows)
+      {
+        context.setWindowPosition(windows[index], x, y);
+      }
+      else
+      {
+        context.setButtonPosition(buttons[index], x, y);
+      }
+    }
+
+    const size_t allocationsBefore = numAllocations;
+    const auto start = std::chrono::steady_clock::now();
+    context.processFrame();
+    const auto end = std::chrono::steady_clock::now();
+    numFrameAllocations += numAllocations - allocationsBefore;
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+    // Only rewritten vertices count, which in retained mode are a fraction of the buffers
+    for (size_t range = 0u; range < context.getNumColorVertexRanges(); ++range)
+    {
+      numBytes += context.getColorVertexRanges()[range].size;
+      numVertices += context.getColorVertexRanges()[range].size / sizeof(ModernUI::ColorVertex);
+    }
+
+    for (size_t range = 0u; range < context.getNumTextureVertexRanges(); ++range)
+    {
+      numBytes += context.getTextureVertexRanges()[range].size;
+      numVertices += context.getTextureVertexRanges()[range].size / sizeof(ModernUI::TextureVertex);
+    }
+  }
+
+  double totalTime = 0.0;
+  for (const double time : times)
+  {
+    totalTime += time;
+  }
+
+  std::sort(times.begin(), times.end());
+
+  SceneResult result;
+  result.p50 = getPercentile(times, 50.0);
+  result.p90 = getPercentile(times, 90.0);
+  result.p99 = getPercentile(times, 99.0);
+  result.max = times.back();
+  result.verticesPerSecond = static_cast<double>(numVertices) / (totalTime / 1000.0);
+  result.bytesPerFrame = static_cast<double>(numBytes) / numSceneFrames;
+  result.allocationsPerFrame = static_cast<double>(numFrameAllocations) / numSceneFrames;
+  return result;
+}
+} // namespace
+
+void* operator new(size_t size)
+{
+  ++numAllocations;
+  if (void* pointer = std::malloc(size > 0u ? size : 1u))
+  {
+    return pointer;
+  }
+
+  throw std::bad_alloc();
+}
+
+// Memory resources allocate through the aligned overloads
+void* operator new(size_t size, std::align_val_t alignment)
+{
+  ++numAllocations;
+  const size_t bytes = static_cast<size_t>(alignment);
+  const size_t alignedSize = (std::max(size, size_t(1u)) + bytes - 1u) / bytes * bytes;
+#if defined(_MSC_VER)
+  if (void* pointer = _aligned_malloc(alignedSize, bytes))
+#else
+  if (void* pointer = std::aligned_alloc(bytes, alignedSize))
+#endif
+  {
+    return pointer;
+  }
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+#if defined(_MSC_VER)
+  _aligned_free(pointer);
+#else
+  std::free(pointer);
+#endif
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+  operator delete(pointer, alignment);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <font.ttf> [results.json]\n";
+    return EXIT_FAILURE;
+  }
+
+  const std::string fontPath = argv[1];
+  std::vector<Result> results;
+  const std::filesystem::path cacheDirectory = std::filesystem::temp_directory_path() / "modernui_bench_cache";
+
+  // Context construction, baking the font every time versus mapping a baked font from the cache
+  {
+    std::filesystem::remove_all(cacheDirectory);
+    std::filesystem::create_directories(cacheDirectory);
+
+    const double coldTime = measureConstruction([&]() {
+      ModernUI::Context context(fontPath);
+      return context.getError() == ModernUI::Context::Error::Success;
+    });
+
+    const double warmTime = measureConstruction([&]() {
+      ModernUI::Context context(fontPath, cacheDirectory.string());
+      return context.getError() == ModernUI::Context::Error::Success;
+    });
+
+    std::filesystem::remove_all(cacheDirectory);
+
+    if (coldTime < 0.0 || warmTime < 0.0)
+    {
+      std::cerr << "Failed to load font " << fontPath << "\n";
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "Context construction, cold bake: " << coldTime << " ms\n";
+    std::cout << "Context construction, warm cache: " << warmTime << " ms\n";
+    results.push_back({ "construction", { { "coldMs", coldTime }, { "warmMs", warmTime } } });
+  }
+
+  // Vertex generation throughput of every supported instruction set
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    for (const size_t numWidgets : { 1000u, 10000u, 100000u })
+    {
+      for (const ModernUI::Context::InstructionSet set :
+           { ModernUI::Context::InstructionSet::Scalar, ModernUI::Context::InstructionSet::SSE2,
+             ModernUI::Context::InstructionSet::AVX2 })
+      {
+        ModernUI::Context probe(font);
+        probe.setInstructionSet(set);
+        if (probe.getInstructionSet() != set)
+        {
+          continue;
+        }
+
+        const double verticesPerSecond = measureVertexThroughput(font, numWidgets, set, false);
+        std::cout << "Vertex generation, " << numWidgets << " widgets, " << getInstructionSetName(set) << ": "
+                  << verticesPerSecond / 1.0e6 << " M vertices/s\n";
+        results.push_back({ "vertex generation, " + std::to_string(numWidgets) + " widgets, " +
+                              getInstructionSetName(set),
+                            { { "verticesPerSecond", verticesPerSecond } } });
+      }
+    }
+  }
+
+  // Added widgets versus widgets that live in the context, with the best instruction set
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    const ModernUI::Context::InstructionSet set = ModernUI::Context(font).getInstructionSet();
+    for (const size_t numWidgets : { 1000u, 10000u, 100000u })
+    {
+      for (const bool contextStorage : { false, true })
+      {
+        const double verticesPerSecond = measureVertexThroughput(font, numWidgets, set, contextStorage);
+        const std::string storage = contextStorage ? "context storage" : "added widgets";
+        std::cout << "Vertex generation, " << numWidgets << " widgets, " << storage << ": "
+                  << verticesPerSecond / 1.0e6 << " M vertices/s\n";
+        results.push_back({ "vertex generation, " + std::to_string(numWidgets) + " widgets, " + storage,
+                            { { "verticesPerSecond", verticesPerSecond } } });
+      }
+    }
+  }
+
+  // Scaling from one thread to all cores, in powers of two
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    const ModernUI::Context::InstructionSet set = ModernUI::Context(font).getInstructionSet();
+    const size_t numCores = std::max(std::thread::hardware_concurrency(), 1u);
+    for (const size_t numWidgets : { 10000u, 100000u, 1000000u })
+    {
+      std::vector<size_t> threadCounts;
+      for (size_t numThreads = 1u; numThreads < numCores; numThreads *= 2u)
+      {
+        threadCounts.push_back(numThreads);
+      }
+
+      threadCounts.push_back(numCores);
+      for (const size_t numThreads : threadCounts)
+      {
+        const double verticesPerSecond = measureVertexThroughput(font, numWidgets, set, true, numThreads);
+        std::cout << "Vertex generation, " << numWidgets << " widgets, " << numThreads << " threads: "
+                  << verticesPerSecond / 1.0e6 << " M vertices/s\n";
+        results.push_back({ "vertex generation, " + std::to_string(numWidgets) + " widgets, " +
+                              std::to_string(numThreads) + " threads",
+                            { { "verticesPerSecond", verticesPerSecond } } });
+      }
+    }
+  }
+
+  // Panning over a large canvas, with and without culling
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    for (const size_t numWidgets : { 10000u, 100000u, 1000000u })
+    {
+      for (const bool cull : { false, true })
+      {
+        const double time = measurePanning(font, numWidgets, cull);
+        std::cout << "Panning, " << numWidgets << " widgets, " << (cull ? "viewport: " : "no viewport: ") << time
+                  << " ms\n";
+        results.push_back({ "panning, " + std::to_string(numWidgets) + " widgets" + (cull ? ", viewport" : ""),
+                            { { "p50Ms", time } } });
+      }
+    }
+  }
+
+  // Finding the widget under the pointer
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    for (const size_t numWidgets : { 10000u, 100000u, 1000000u })
+    {
+      const double time = measureHitTesting(font, numWidgets);
+      std::cout << "Hit testing, " << numWidgets << " widgets: " << time << " us per query\n";
+      results.push_back({ "hit testing, " + std::to_string(numWidgets) + " widgets", { { "queryUs", time } } });
+    }
+  }
+
+  // Dragging a panel with children
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    for (const bool parented : { false, true })
+    {
+      const double time = measureDragging(font, 1000u, parented);
+      std::cout << "Dragging, 1000 children, " << (parented ? "parented: " : "flat: ") << time << " ms\n";
+      results.push_back({ std::string("dragging, 1000 children") + (parented ? ", parented" : ", flat"),
+                          { { "p50Ms", time } } });
+    }
+  }
+
+  // Editing labels in a large layout
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    const double time = measureRelayout(font, 100u, 100u);
+    std::cout << "Relayout, 10000 buttons, one label edit: " << time << " ms\n";
+    results.push_back({ "relayout, 10000 buttons", { { "p50Ms", time } } });
+  }
+
+  // Layers of buttons hidden behind each other, with and without occlusion culling
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    for (const bool occlusion : { false, true })
+    {
+      const double time = measureStackedLayers(font, 10u, occlusion);
+      std::cout << "Stacked layers, 10 x 1000 buttons, " << (occlusion ? "occlusion culling: " : "no culling: ") << time
+                << " ms\n";
+      results.push_back({ std::string("stacked layers, 10 x 1000 buttons") + (occlusion ? ", occlusion culling" : ""),
+                          { { "p50Ms", time } } });
+    }
+  }
+
+  // Frames while other threads queue changes
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    for (const size_t numProducers : { 1u, 4u })
+    {
+      const std::pair<double, double> result = measureQueuedUpdates(font, numProducers);
+      std::cout << "Queued updates, " << numProducers << " producers: " << result.first << " ms, "
+                << result.second / 1.0e6 << " M changes/s\n";
+      results.push_back({ "queued updates, " + std::to_string(numProducers) + " producers",
+                          { { "p50Ms", result.first }, { "changesPerSecond", result.second } } });
+    }
+  }
+
+  // Synthetic scenes, mostly static or fully animated, drawn immediately or retained. The unit tests make sure that
+  // warmed up frames do not allocate.
+  {
+    const auto font = std::make_shared<const ModernUI::Font>(fontPath);
+    for (const Scene scene : { Scene::Windows, Scene::Buttons, Scene::LongLabels })
+    {
+      for (const size_t numWidgets : { 1000u, 10000u, 100000u })
+      {
+        // Long labels emit a lot more vertices per widget
+        if (scene == Scene::LongLabels && numWidgets > 10000u)
+        {
+          continue;
+        }
+
+        for (const bool animated : { false, true })
+        {
+          for (const bool retained : { false, true })
+          {
+            const SceneResult result = measureScene(font, scene, numWidgets, animated, retained);
+            const std::string name = std::string(getSceneName(scene)) + ", " + std::to_string(numWidgets) +
+                                     " widgets, " + (animated ? "animated" : "static") + ", " +
+                                     (retained ? "retained" : "immediate");
+            std::cout << "Scene, " << name << ": p50 " << result.p50 << " ms, p99 " << result.p99 << " ms, "
+                      << result.verticesPerSecond / 1.0e6 << " M vertices/s, " << result.bytesPerFrame / 1024.0
+                      << " KiB and " << result.allocationsPerFrame << " allocations per frame\n";
+            results.push_back({ "scene, " + name,
+                                { { "p50Ms", result.p50 },
+                                  { "p90Ms", result.p90 },
+                                  { "p99Ms", result.p99 },
+                                  { "maxMs", result.max },
+                                  { "verticesPerSecond", result.verticesPerSecond },
+                                  { "bytesPerFrame", result.bytesPerFrame },
+                                  { "allocationsPerFrame", result.allocationsPerFrame } } });
+          }
+        }
+      }
+    }
+  }
+
+  if (argc > 2)
+  {
+    writeJson(argv[2], results);
+  }
+
+  return EXIT_SUCCESS;
+}
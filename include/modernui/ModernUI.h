@@ -2,25 +2,221 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 
 namespace ModernUI
 {
+// Vertices are always built from floats and read back through the getters, so that the layout can be switched at
+// compile time. The compact layouts store whole pixel positions as 16-bit integers, colors as RGBA8 with red in the
+// lowest byte, texture coordinates as normalized 16-bit integers and scales in 1/256 steps, which makes color vertices
+// 8 bytes and texture vertices 10 bytes.
+#if defined(MODERNUI_COMPACT_VERTICES)
+struct ColorVertex final
+{
+  int16_t x, y;
+  uint32_t color;
+
+  ColorVertex() = default;
+  ColorVertex(float x, float y, float r, float g, float b);
+
+  float getX() const;
+  float getY() const;
+  float getR() const;
+  float getG() const;
+  float getB() const;
+};
+
+struct TextureVertex final
+{
+  int16_t x, y;
+  uint16_t u, v;
+  uint16_t scale;
+
+  TextureVertex() = default;
+  TextureVertex(float x, float y, float u, float v, float scale);
+
+  float getX() const;
+  float getY() const;
+  float getU() const;
+  float getV() const;
+  float getScale() const;
+};
+
+// Renderers set up their vertex formats with these sizes
+static_assert(sizeof(ColorVertex) == 8u, "Compact color vertices are 8 bytes");
+static_assert(sizeof(TextureVertex) == 10u, "Compact texture vertices are 10 bytes");
+#else
 struct ColorVertex final
 {
   float x, y;
   float r, g, b;
 
+  ColorVertex() = default;
   ColorVertex(float x, float y, float r, float g, float b);
+
+  float getX() const;
+  float getY() const;
+  float getR() const;
+  float getG() const;
+  float getB() const;
 };
 
+// The scale of a texture vertex is the number of pixels per texel of the font texture, which distance field text
+// needs for antialiasing
 struct TextureVertex final
 {
   float x, y;
   float u, v;
+  float scale;
+
+  TextureVertex() = default;
+  TextureVertex(float x, float y, float u, float v, float scale);
+
+  float getX() const;
+  float getY() const;
+  float getU() const;
+  float getV() const;
+  float getScale() const;
+};
+#endif
+
+// A flat colored rectangle for instanced drawing, the color is packed as RGBA8 with red in the lowest byte
+struct RectangleInstance final
+{
+  float x, y;
+  float width, height;
+  uint32_t color;
+
+  RectangleInstance() = default;
+  RectangleInstance(float x, float y, float width, float height, float r, float g, float b);
+};
+
+// Reference expansion of rectangle instances into the six vertices per rectangle that a renderer would generate
+void expandRectangleInstances(const RectangleInstance* instances, size_t numInstances, ColorVertex* vertices);
+
+// Reference fragment shader for distance field text, returns the coverage of a pixel given the filtered font texture
+// value between zero and one and the scale of the texture vertices. In GLSL this is
+//   clamp((value * 255.0 - 128.0) / 32.0 * scale + 0.5, 0.0, 1.0)
+float shadeDistanceField(float value, float scale);
+
+struct Rect final
+{
+  int32_t x, y;
+  int32_t width, height;
+};
+
+struct ByteRange final
+{
+  size_t offset;
+  size_t size;
+};
+
+// One draw call over a range of an output stream. Color commands draw color vertices, rectangle commands rectangle
+// instances and text commands texture vertices with the font texture, which is the only texture page. Indexed quads
+// are drawn with the indices of their vertices, which start at first / 4 * 6.
+struct DrawCommand final
+{
+  enum class Pipeline
+  {
+    Color,
+    Rectangle,
+    Text
+  };
+
+  Pipeline pipeline;
+  size_t first;
+  size_t count;
+  uint32_t texturePage;
+
+  // The viewport, or an empty rect when there is none
+  Rect clipRect;
+
+  // Widgets are in a higher layer than everything drawn before them that they overlap
+  uint32_t layer;
+};
+
+// Memory that a context writes its output into, such as a persistently mapped GPU buffer. Capacities count elements,
+// streams that are not used may be left empty.
+struct OutputBuffers final
+{
+  ColorVertex* colorVertices = nullptr;
+  size_t colorVertexCapacity = 0u;
 
-  TextureVertex(float x, float y, float u, float v);
+  TextureVertex* textureVertices = nullptr;
+  size_t textureVertexCapacity = 0u;
+
+  RectangleInstance* rectangleInstances = nullptr;
+  size_t rectangleInstanceCapacity = 0u;
+};
+
+// Identifies a widget that lives in a context. Slots of destroyed widgets are reused, but their old handles never
+// become valid again.
+struct WindowHandle final
+{
+  uint32_t slot;
+  uint32_t generation;
+};
+
+struct ButtonHandle final
+{
+  uint32_t slot;
+  uint32_t generation;
+};
+
+// Identifies a window or a button in query and input results
+struct WidgetHandle final
+{
+  enum class Type
+  {
+    None,
+    Window,
+    Button
+  };
+
+  Type type = Type::None;
+  uint32_t slot = 0u;
+  uint32_t generation = 0u;
+
+  WidgetHandle() = default;
+  WidgetHandle(WindowHandle window);
+  WidgetHandle(ButtonHandle button);
+};
+
+bool operator==(const WidgetHandle& a, const WidgetHandle& b);
+bool operator!=(const WidgetHandle& a, const WidgetHandle& b);
+
+// Counters of one processFrame(), the phase times are in milliseconds and summed over all threads
+struct FrameStats final
+{
+  // Widgets with a range in the vertex buffers, and the ones among them that were unchanged and not rewritten
+  size_t numWidgetsVisited = 0u;
+  size_t numWidgetsSkipped = 0u;
+
+  // Widgets outside of the viewport, and widgets inside of it that are hidden behind others
+  size_t numWidgetsCulled = 0u;
+  size_t numWidgetsOccluded = 0u;
+
+  // Rewritten parts of the vertex buffers
+  size_t numColorVertices = 0u;
+  size_t numTextureVertices = 0u;
+  size_t numRectangleInstances = 0u;
+  size_t numBytesWritten = 0u;
+
+  // Glyphs of the rewritten labels, and characters that had no glyph
+  size_t numGlyphs = 0u;
+  size_t numGlyphsDropped = 0u;
+
+  // Output, range and label vectors that had to grow
+  size_t numReallocations = 0u;
+
+  double windowTime = 0.0;
+  double buttonTime = 0.0;
+  double textTime = 0.0;
+  double frameTime = 0.0;
 };
 
 class Context final
@@ -33,23 +229,371 @@ public:
     FontBakeFailed
   };
 
+  enum class InstructionSet
+  {
+    Scalar,
+    SSE2,
+    AVX2
+  };
+
+  enum class IndexType
+  {
+    None,
+    UInt16,
+    UInt32
+  };
+
+  enum class LayoutDirection
+  {
+    None,
+    Row,
+    Column
+  };
+
+  // Runs task(0) to task(numTasks - 1), possibly in parallel, and returns once all of them finished
+  using TaskExecutor = std::function<void(size_t numTasks, const std::function<void(size_t task)>& task)>;
+
+  // These load a font that only this context uses, see Font for the parameters
   Context();
+  explicit Context(const std::string& fontPath, const std::string& fontCacheDirectory = std::string());
+  Context(const unsigned char* fontData, size_t fontDataSize, const std::string& fontCacheDirectory = std::string());
+
+  // Contexts that share a font also share its baked texture. Everything a context stores per widget and per frame is
+  // allocated from the memory resource, which has to be thread-safe when frames run on more than one thread or changes
+  // are queued by other threads. Once every container reached its size, processing a frame with the same widgets does
+  // not allocate at all. There is no built-in frame arena or widget pool, pass a std::pmr::unsynchronized_pool_resource
+  // to pool allocations, or a std::pmr::synchronized_pool_resource when the resource has to be thread-safe. Window and
+  // Button objects allocate their own data with new, outside of any context.
+  explicit Context(std::shared_ptr<const class Font> font,
+                   std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
   ~Context();
 
   Error getError() const;
 
+  // Added widgets must outlive the context or be removed first. Their properties are copied whenever their revision
+  // changes. Destroying an added widget through its handle removes it as well.
   void addWindow(const class Window& window);
   void addButton(const class Button& button);
+  void removeWindow(const class Window& window);
+  void removeButton(const class Button& button);
+
+  // Widgets can also live in the context itself, stored as structure of arrays. Creating and destroying them takes
+  // constant time and setters called with invalid handles are ignored. All widgets are drawn in slot order, windows
+  // before buttons.
+  WindowHandle createWindow(int32_t x, int32_t y, int32_t width, int32_t height);
+  void destroyWindow(WindowHandle window);
+  bool isValid(WindowHandle window) const;
+  void setWindowPosition(WindowHandle window, int32_t x, int32_t y);
+  void setWindowSize(WindowHandle window, int32_t width, int32_t height);
+  void setWindowColor(WindowHandle window, float r, float g, float b);
+
+  ButtonHandle createButton(std::string_view text, int32_t x, int32_t y, int32_t width, int32_t height);
+  void destroyButton(ButtonHandle button);
+  bool isValid(ButtonHandle button) const;
+  void setButtonText(ButtonHandle button, std::string_view text);
+  void setButtonPosition(ButtonHandle button, int32_t x, int32_t y);
+  void setButtonSize(ButtonHandle button, int32_t width, int32_t height);
+
+  // These setters are the only calls that are thread-safe. Any number of threads can call them at the same time, also
+  // while another one runs processFrame(). They queue the change without blocking, and the next processFrame() applies
+  // all queued changes in order before it reads any widget. Changes to widgets that were destroyed by then are ignored.
+  // Queueing allocates from the memory resource while the queue grows to the most changes queued between two frames,
+  // and for labels longer than the reused storage, so the resource has to be thread-safe as well. Every other call,
+  // including adding, removing, creating and destroying widgets, the other setters, the getters and the setters of
+  // added Window and Button objects, belongs to the thread that runs processFrame(). Other threads may only make them
+  // while no frame runs and with their own synchronization, the context does not copy its state for them.
+  void queueWindowPosition(WindowHandle window, int32_t x, int32_t y);
+  void queueWindowSize(WindowHandle window, int32_t width, int32_t height);
+  void queueWindowColor(WindowHandle window, float r, float g, float b);
+  void queueButtonText(ButtonHandle button, std::string_view text);
+  void queueButtonPosition(ButtonHandle button, int32_t x, int32_t y);
+  void queueButtonSize(ButtonHandle button, int32_t width, int32_t height);
+
+  // Windows can be the parent of other widgets, whose positions are then relative to it. Moving a window moves its
+  // whole subtree, which the next processFrame() resolves by walking only the subtrees of moved windows. Setting a
+  // parent fails for widgets that are not alive, parents that are not windows and parents inside the subtree of the
+  // widget. Positions are not converted when the parent changes, children of a destroyed or removed window are
+  // positioned relative to the origin again.
+  bool setParent(WidgetHandle widget, WidgetHandle parent);
+  void clearParent(WidgetHandle widget);
+  WidgetHandle getParent(WidgetHandle widget) const;
+
+  // Windows with a layout place their children one after the other in a row or a column, with padding around them and
+  // spacing in between, and grow to fit them. Laid out widgets are measured as their set size grown to fit their label,
+  // clamped to their size limits, and the ones that fill share the remaining space and stretch across. Their positions
+  // are set by the layout. Measurements are cached and only the branches of changed widgets are laid out again, before
+  // the next processFrame() or query.
+  void setWindowLayout(WindowHandle window, LayoutDirection direction, int32_t padding, int32_t spacing);
+  void setWidgetSizeLimits(WidgetHandle widget,
+                           int32_t minWidth,
+                           int32_t minHeight,
+                           int32_t maxWidth,
+                           int32_t maxHeight);
+  void setWidgetFill(WidgetHandle widget, bool fill);
+
+  // Absolute position and size of a widget after layout
+  Rect getWidgetBounds(WidgetHandle widget);
+
+  // In retained mode, every widget keeps a stable range in the vertex buffers and only widgets whose setters ran since
+  // the previous frame are rewritten. Label ranges have spare capacity which is filled with degenerate triangles.
+  bool getRetainedMode() const;
+  void setRetainedMode(bool enabled);
+
+  // With an index type set, every quad is emitted as four unique vertices and drawn with the shared index buffer
+  IndexType getIndexType() const;
+  void setIndexType(IndexType type);
+
+  // With instanced rectangles, window and button boxes are emitted as rectangle instances instead of color vertices
+  bool getInstancedRectangles() const;
+  void setInstancedRectangles(bool enabled);
+
+  // With a draw list, every frame also produces draw commands that stack widgets correctly, where drawing the streams
+  // one after the other puts every label above every box and every button above every window. Windows are stacked in
+  // slot order, each together with its descendants, and buttons without a parent after them. Commands are sorted by
+  // layer and pipeline, and consecutive ranges of the same pipeline are merged into one command.
+  bool getDrawList() const;
+  void setDrawList(bool enabled);
+
+  // With dynamic glyphs, label text is decoded as UTF-8 and glyphs are rasterized into the font texture on first use.
+  // When the texture is full, the least recently used glyphs are evicted.
+  bool getDynamicGlyphs() const;
+  void setDynamicGlyphs(bool enabled);
+
+  // With distance field text, labels are handled as with dynamic glyphs but glyphs are rasterized as signed distance
+  // fields, which stay sharp at any text scale. The font texture then has to be drawn with shadeDistanceField()
+  // instead of as plain coverage.
+  bool getDistanceFieldText() const;
+  void setDistanceFieldText(bool enabled);
+
+  // Labels are drawn this many times their baked size, which is meant for zooming and high DPI displays. Without
+  // distance field text the glyphs are stretched. Scales that are not positive are ignored.
+  float getTextScale() const;
+  void setTextScale(float scale);
+
+  // Vertices are generated with the best instruction set the CPU supports, unsupported ones are ignored. Every
+  // instruction set produces exactly the same vertices. Builds with compact vertices only support the scalar one.
+  InstructionSet getInstructionSet() const;
+  void setInstructionSet(InstructionSet set);
+
+  // With more than one thread, frames are split into chunks of widgets that worker threads owned by the context process
+  // in parallel. Chunks do not depend on the number of threads, so every thread count produces exactly the same output.
+  size_t getNumThreads() const;
+  void setNumThreads(size_t numThreads);
+
+  // Runs the chunks with the job system of the application instead of worker threads, an empty executor goes back to
+  // processing them on the calling thread
+  void setTaskExecutor(TaskExecutor executor);
+
+  // With a viewport, only widgets that overlap it are emitted and labels are clipped to their button. Visible widgets
+  // are found through a spatial index that is updated as widgets change, so culled widgets cost next to nothing.
+  void setViewport(const Rect& viewport);
+  void clearViewport();
+  bool hasViewport() const;
+  Rect getViewport() const;
+
+  // With occlusion culling, widgets that are completely hidden behind the boxes of widgets drawn after them are not
+  // emitted, and neither are their labels. Boxes are opaque, labels never hide anything. What is hidden is only found
+  // again after widgets or the viewport changed.
+  bool getOcclusionCulling() const;
+  void setOcclusionCulling(bool enabled);
+
+  // Widgets are found through the spatial index. Buttons are on top of windows and later slots on top of earlier ones.
+  // Added widgets are seen as they were during the last processFrame(), and are reported by the handle of the slot
+  // that mirrors them.
+  WidgetHandle findWidget(int32_t x, int32_t y);
+  size_t findWidgets(const Rect& rect);
+  const WidgetHandle* getFoundWidgets() const;
+
+  // Returns the added widget that a handle refers to, or nullptr for widgets that live in the context
+  const Window* getWindow(WidgetHandle widget) const;
+  const Button* getButton(WidgetHandle widget) const;
+
+  // Returns the handle of the slot that mirrors an added widget, or an empty handle if it was not added
+  WidgetHandle getWidget(const class Window& window) const;
+  WidgetHandle getWidget(const class Button& button) const;
+
+  // Pointer input is queued and handled in one pass by the next processFrame(). A click is a press and a release over
+  // the same widget.
+  void setPointerPosition(int32_t x, int32_t y);
+  void setPointerButton(bool down);
+
+  // Results of the last processFrame()
+  WidgetHandle getHoveredWidget() const;
+  WidgetHandle getPressedWidget() const;
+  size_t getNumClickedWidgets() const;
+  const WidgetHandle* getClickedWidgets() const;
+
+  // Scoped events of every frame are recorded into the sink, which must outlive the context or be unset first.
+  // Without a sink, tracing costs a branch per event.
+  void setTraceSink(class TraceSink* sink);
+
+  // With output buffers, processFrame() writes vertices straight into them instead of into the context, which saves
+  // copying them into a GPU buffer. The buffers must stay valid and untouched until they are replaced or cleared. In
+  // retained mode, only changed ranges are written as long as the same buffers are set every frame, other buffers
+  // cause a full rewrite.
+  void setOutputBuffers(const OutputBuffers& buffers);
+  void clearOutputBuffers();
 
   void processFrame();
 
+  FrameStats getFrameStats() const;
+
+  // Frames that need more than the output buffers hold are written into the context instead, the vertex getters then
+  // report the required sizes. Larger buffers are used from the next frame on.
+  bool hasOutputOverflow() const;
+
+  // False if the last frame looks exactly like the one before and did not change the output, so that uploading and
+  // presenting it can be skipped
+  bool hasFrameChanged() const;
+
+  // Areas that may look different than in the frame before, each one covers the old and the new bounds of a changed
+  // widget. Areas are clipped to the viewport and merged into their bounds when there are too many of them.
+  size_t getNumDamageRects() const;
+  const Rect* getDamageRects() const;
+  Rect getDamageBounds() const;
+
   size_t getNumColorVertices() const;
   const ColorVertex* getColorVertices() const;
 
   size_t getNumTextureVertices() const;
   const TextureVertex* getTextureVertices() const;
 
-  unsigned char* getFontTextureData() const;
+  size_t getNumRectangleInstances() const;
+  const RectangleInstance* getRectangleInstances() const;
+
+  // Commands of the last processFrame() in the order they have to be drawn, none without a draw list. With 16-bit
+  // indices, commands over more quads than the index buffer covers have to be split like the streams.
+  size_t getNumDrawCommands() const;
+  const DrawCommand* getDrawCommands() const;
+
+  // The index buffer is shared by both vertex streams. 16-bit indices cover at most 16384 quads, draw larger streams in
+  // batches of that size with a base vertex.
+  size_t getNumColorIndices() const;
+  size_t getNumTextureIndices() const;
+  const void* getIndices() const;
+
+  // Byte ranges of the vertex buffers that were rewritten by the last call to processFrame()
+  size_t getNumColorVertexRanges() const;
+  const ByteRange* getColorVertexRanges() const;
+
+  size_t getNumTextureVertexRanges() const;
+  const ByteRange* getTextureVertexRanges() const;
+
+  size_t getNumRectangleInstanceRanges() const;
+  const ByteRange* getRectangleInstanceRanges() const;
+
+  // Regions of the font texture that were written by the last call to processFrame()
+  size_t getNumFontTextureRegions() const;
+  const Rect* getFontTextureRegions() const;
+
+  const unsigned char* getFontTextureData() const;
+
+  std::shared_ptr<const Font> getFont() const;
+
+private:
+  struct Data;
+  std::unique_ptr<Data> d;
+};
+
+// A font and its baked texture, which never change after construction and can therefore be shared by any number of
+// contexts on any number of threads
+class Font final
+{
+public:
+  // The font is memory mapped where supported. Baked font textures are loaded from and saved to the cache directory if
+  // one is given, so that later launches can skip the bake.
+  explicit Font(const std::string& path, const std::string& cacheDirectory = std::string());
+
+  // The font data must outlive the font
+  Font(const unsigned char* data, size_t size, const std::string& cacheDirectory = std::string());
+
+  ~Font();
+
+  Font(const Font&) = delete;
+  Font& operator=(const Font&) = delete;
+
+  Context::Error getError() const;
+
+  const unsigned char* getTextureData() const;
+
+private:
+  friend class Context;
+
+  struct Data;
+  std::unique_ptr<Data> d;
+};
+
+// Keeps the last timed events of any number of threads in a ring buffer, recording never blocks or allocates
+class TraceSink final
+{
+public:
+  // Records the time from its construction to its destruction, the name must outlive the sink
+  class Scope final
+  {
+  public:
+    Scope(TraceSink* sink, const char* name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    TraceSink* sink;
+    const char* name;
+    uint64_t start;
+  };
+
+  // Once full, the oldest events are overwritten
+  explicit TraceSink(size_t capacity = 65536u);
+  ~TraceSink();
+
+  TraceSink(const TraceSink&) = delete;
+  TraceSink& operator=(const TraceSink&) = delete;
+
+  // Nanoseconds since the sink was created
+  uint64_t getTime() const;
+
+  void record(const char* name, uint64_t start, uint64_t end);
+
+  // Events recorded so far, including overwritten ones
+  size_t getNumEvents() const;
+
+  // Not safe while other threads record
+  void clear();
+
+  // Trace event JSON as understood by chrome://tracing and Perfetto. Events that are being recorded concurrently are
+  // left out.
+  std::string exportChromeTrace() const;
+
+private:
+  struct Data;
+  std::unique_ptr<Data> d;
+};
+
+// Splits output memory into equal slots for a number of frames in flight, the way a renderer cycles through the regions
+// of a persistently mapped buffer. A slot is handed out again only after the frame that used it was released.
+class OutputRing final
+{
+public:
+  OutputRing(const OutputBuffers& memory, size_t numSlots);
+  ~OutputRing();
+
+  OutputRing(const OutputRing&) = delete;
+  OutputRing& operator=(const OutputRing&) = delete;
+
+  size_t getNumSlots() const;
+  size_t getNumFramesInFlight() const;
+
+  // Moves on to the next slot, or returns false if every slot is still in flight
+  bool acquire();
+
+  // The slot of the last acquired frame
+  size_t getSlot() const;
+  OutputBuffers getBuffers() const;
+
+  // Called once the oldest frame in flight is done, such as when its fence was signaled
+  void release();
 
 private:
   struct Data;
@@ -62,6 +606,9 @@ public:
   Window(int32_t x, int32_t y, int32_t width, int32_t height);
   ~Window();
 
+  // Incremented by every setter, allows a context to detect changes
+  uint32_t getRevision() const;
+
   int32_t getX() const;
   int32_t getY() const;
   void setPosition(int32_t x, int32_t y);
@@ -83,11 +630,15 @@ private:
 class Button final
 {
 public:
-  Button(const std::string& text, int32_t x, int32_t y, int32_t width, int32_t height);
+  Button(std::string_view text, int32_t x, int32_t y, int32_t width, int32_t height);
   ~Button();
 
-  std::string getText() const;
-  void setText(const std::string& text);
+  // Incremented by every setter, allows a context to detect changes
+  uint32_t getRevision() const;
+
+  // Valid until the text is set again
+  std::string_view getText() const;
+  void setText(std::string_view text);
 
   int32_t getX() const;
   int32_t getY() const;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ModernUI.h"
+
+namespace ModernUI
+{
+// Renders the output of a context on the CPU, the way the test program does with OpenGL. Triangles are binned into
+// screen tiles which are shaded in parallel, every tile draws its triangles in order so the image does not depend on
+// the number of threads.
+class Rasterizer final
+{
+public:
+  // The number of threads includes the calling thread
+  Rasterizer(int32_t width, int32_t height, size_t numThreads = 1u);
+  ~Rasterizer();
+
+  Rasterizer(const Rasterizer&) = delete;
+  Rasterizer& operator=(const Rasterizer&) = delete;
+
+  int32_t getWidth() const;
+  int32_t getHeight() const;
+
+  // Labels are drawn in this color, with the font texture as alpha or as distance field
+  void setTextColor(float r, float g, float b);
+
+  void clear(float r, float g, float b);
+
+  // Draws the color vertices or rectangle instances, then the texture vertices of the last frame of the context. With a
+  // draw list, the draw commands are drawn in their order instead. Indexed output is supported.
+  void draw(const Context& context);
+
+  // RGBA8 with red in the lowest byte, rows from top to bottom
+  const uint32_t* getPixels() const;
+
+private:
+  struct Data;
+  std::unique_ptr<Data> d;
+};
+} // namespace ModernUI
@@ -0,0 +1,833 @@
+#include "Rasterizer.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define MODERNUI_RASTERIZER_SSE2
+  #include <emmintrin.h>
+#endif
+
+namespace ModernUI
+{
+namespace
+{
+constexpr int32_t tileShift = 6;
+constexpr int32_t tileSize = 1 << tileShift;
+
+// Triangles are set up and binned in chunks of this many, every chunk keeps its own bins so that tiles can draw the
+// chunks one after the other and still see the triangles in order
+constexpr size_t trianglesPerChunk = 16384u;
+
+// Matches the font texture of the context
+constexpr int32_t fontTextureSize = 512;
+
+constexpr size_t maxQuadsPerUInt16Batch = 16384u;
+constexpr size_t indicesPerQuad = 6u;
+constexpr size_t verticesPerIndexedQuad = 4u;
+
+// E(x, y) = a * x + b * y + c is positive inside the triangle. Pixels exactly on an edge are only drawn for inclusive
+// edges, and an edge shared by two triangles is inclusive for exactly one of them, so that nothing is blended twice.
+struct Edge final
+{
+  float a, b, c;
+  float inverseA;
+};
+
+struct Triangle final
+{
+  // Edge i is opposite of vertex i, its value divided by the area is the barycentric weight of that vertex
+  Edge edges[3];
+  uint32_t inclusiveEdges;
+  float inverseArea;
+  int32_t minX, minY, maxX, maxY;
+
+  // Color or texture coordinates at the first vertex, and their differences to the second and third
+  float attributes[3];
+  float attributes1[3];
+  float attributes2[3];
+  bool textured;
+};
+
+struct Chunk final
+{
+  std::vector<Triangle> triangles;
+
+  // Bin entries as tile and triangle, and the triangles sorted by tile
+  std::vector<uint64_t> entries;
+  std::vector<uint32_t> firstEntries;
+  std::vector<uint32_t> binnedTriangles;
+};
+
+struct Vertex final
+{
+  float x, y;
+  float attributes[3];
+};
+
+// Consecutive triangles of one stream, a draw goes through its ranges in order
+struct TriangleRange final
+{
+  bool textured;
+  size_t firstTriangle;
+  size_t numTriangles;
+};
+
+uint8_t toByte(float value)
+{
+  return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+uint32_t packColor(float r, float g, float b)
+{
+  return toByte(r) | (toByte(g) << 8) | (toByte(b) << 16) | (255u << 24);
+}
+
+constexpr float inverse255 = 1.0f / 255.0f;
+
+float getChannel(uint32_t color, int32_t shift)
+{
+  return static_cast<float>((color >> shift) & 255u) * inverse255;
+}
+
+// Bilinear with wrapping, like the font texture of the test program
+float sample(const unsigned char* texture, float u, float v)
+{
+  // Shifted to positive coordinates so that truncating rounds down, wrapping makes the shift disappear
+  const float s = u * fontTextureSize - 0.5f + fontTextureSize;
+  const float t = v * fontTextureSize - 0.5f + fontTextureSize;
+  const int32_t x = static_cast<int32_t>(s);
+  const int32_t y = static_cast<int32_t>(t);
+  const float fractionX = s - static_cast<float>(x);
+  const float fractionY = t - static_cast<float>(y);
+
+  constexpr int32_t mask = fontTextureSize - 1;
+  const int32_t x0 = x & mask;
+  const int32_t y0 = y & mask;
+  const int32_t x1 = (x0 + 1) & mask;
+  const int32_t y1 = (y0 + 1) & mask;
+
+  const float t00 = texture[y0 * fontTextureSize + x0];
+  const float t10 = texture[y0 * fontTextureSize + x1];
+  const float t01 = texture[y1 * fontTextureSize + x0];
+  const float t11 = texture[y1 * fontTextureSize + x1];
+
+  const float top = t00 + (t10 - t00) * fractionX;
+  const float bottom = t01 + (t11 - t01) * fractionX;
+  return (top + (bottom - top) * fractionY) * inverse255;
+}
+
+uint32_t blend(uint32_t destination, float r, float g, float b, float alpha)
+{
+  const float inverseAlpha = 1.0f - alpha;
+  const float destinationAlpha = getChannel(destination, 24);
+  return toByte(r * alpha + getChannel(destination, 0) * inverseAlpha) |
+         (toByte(g * alpha + getChannel(destination, 8) * inverseAlpha) << 8) |
+         (toByte(b * alpha + getChannel(destination, 16) * inverseAlpha) << 16) |
+         (toByte(alpha + destinationAlpha * inverseAlpha) << 24);
+}
+
+// Returns false for triangles without area or pixels on screen
+bool setup(const Vertex& v0, const Vertex& v1, const Vertex& v2, bool textured, int32_t width, int32_t height,
+           Triangle& triangle)
+{
+  const Vertex* vertices[3] = { &v0, &v1, &v2 };
+
+  float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+  if (area == 0.0f || std::isnan(area))
+  {
+    return false;
+  }
+
+  // Either winding is drawn
+  if (area < 0.0f)
+  {
+    std::swap(vertices[1], vertices[2]);
+    area = -area;
+  }
+
+  const float minX = std::min({ v0.x, v1.x, v2.x });
+  const float minY = std::min({ v0.y, v1.y, v2.y });
+  const float maxX = std::max({ v0.x, v1.x, v2.x });
+  const float maxY = std::max({ v0.y, v1.y, v2.y });
+
+  // Pixel centers inside the bounds
+  triangle.minX = static_cast<int32_t>(std::max(std::ceil(minX - 0.5f), 0.0f));
+  triangle.minY = static_cast<int32_t>(std::max(std::ceil(minY - 0.5f), 0.0f));
+  triangle.maxX = static_cast<int32_t>(std::min(std::floor(maxX - 0.5f) + 1.0f, static_cast<float>(width)));
+  triangle.maxY = static_cast<int32_t>(std::min(std::floor(maxY - 0.5f) + 1.0f, static_cast<float>(height)));
+  if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY)
+  {
+    return false;
+  }
+
+  triangle.inclusiveEdges = 0u;
+  for (uint32_t index = 0u; index < 3u; ++index)
+  {
+    const Vertex& from = *vertices[(index + 1u) % 3u];
+    const Vertex& to = *vertices[(index + 2u) % 3u];
+    const float dx = to.x - from.x;
+    const float dy = to.y - from.y;
+
+    Edge& edge = triangle.edges[index];
+    edge.a = -dy;
+    edge.b = dx;
+    edge.c = dy * from.x - dx * from.y;
+    edge.inverseA = dy != 0.0f ? -1.0f / dy : 0.0f;
+
+    if (dy > 0.0f || (dy == 0.0f && dx < 0.0f))
+    {
+      triangle.inclusiveEdges |= 1u << index;
+    }
+  }
+
+  triangle.inverseArea = 1.0f / area;
+  for (uint32_t index = 0u; index < 3u; ++index)
+  {
+    triangle.attributes[index] = vertices[0]->attributes[index];
+    triangle.attributes1[index] = vertices[1]->attributes[index] - vertices[0]->attributes[index];
+    triangle.attributes2[index] = vertices[2]->attributes[index] - vertices[0]->attributes[index];
+  }
+
+  triangle.textured = textured;
+  return true;
+}
+
+// Whether any part of a tile can be inside, by testing the corner of the tile that is furthest inside every edge
+bool overlapsTile(const Triangle& triangle, int32_t tileX, int32_t tileY)
+{
+  const float left = static_cast<float>(tileX << tileShift) + 0.5f;
+  const float top = static_cast<float>(tileY << tileShift) + 0.5f;
+  const float right = left + (tileSize - 1);
+  const float bottom = top + (tileSize - 1);
+
+  for (const Edge& edge : triangle.edges)
+  {
+    const float x = edge.a > 0.0f ? right : left;
+    const float y = edge.b > 0.0f ? bottom : top;
+    if (edge.a * x + edge.b * y + edge.c < 0.0f)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Shades up to four pixels of a row, starting at x, whose lanes are set in the coverage mask
+void shade(const Triangle& triangle,
+           uint32_t* row,
+           int32_t x,
+           uint32_t mask,
+           const float* weights1,
+           const float* weights2,
+           const unsigned char* texture,
+           bool distanceField,
+           const float* textColor)
+{
+  for (int32_t lane = 0; lane < 4; ++lane)
+  {
+    if (!(mask & (1u << lane)))
+    {
+      continue;
+    }
+
+    float values[3];
+    for (uint32_t index = 0u; index < 3u; ++index)
+    {
+      values[index] = triangle.attributes[index] + weights1[lane] * triangle.attributes1[index] +
+                      weights2[lane] * triangle.attributes2[index];
+    }
+
+    uint32_t& pixel = row[x + lane];
+    if (triangle.textured)
+    {
+      // Most of a glyph quad is empty, the third value is the scale
+      const float texel = sample(texture, values[0], values[1]);
+      const float alpha = distanceField ? shadeDistanceField(texel, values[2]) : texel;
+      if (alpha > 0.0f)
+      {
+        pixel = blend(pixel, textColor[0], textColor[1], textColor[2], alpha);
+      }
+    }
+    else
+    {
+      pixel = packColor(values[0], values[1], values[2]);
+    }
+  }
+}
+
+// Narrows a row down to the pixels that can be inside, with a margin, since the edges are tested exactly afterwards.
+// Returns false if no pixel of the row can be inside.
+bool getRowSpan(const Triangle& triangle, const float* rowC, int32_t& minX, int32_t& maxX)
+{
+  float start = static_cast<float>(minX);
+  float end = static_cast<float>(maxX);
+  for (uint32_t index = 0u; index < 3u; ++index)
+  {
+    const float a = triangle.edges[index].a;
+    if (a == 0.0f)
+    {
+      if (rowC[index] < 0.0f)
+      {
+        return false;
+      }
+
+      continue;
+    }
+
+    // Where the edge crosses the row, in pixels rather than pixel centers
+    const float crossing = -rowC[index] * triangle.edges[index].inverseA - 0.5f;
+    if (a > 0.0f)
+    {
+      start = std::max(start, crossing - 2.0f);
+    }
+    else
+    {
+      end = std::min(end, crossing + 3.0f);
+    }
+  }
+
+  if (start >= end)
+  {
+    return false;
+  }
+
+  minX = static_cast<int32_t>(start);
+  maxX = static_cast<int32_t>(end);
+  return true;
+}
+
+#if defined(MODERNUI_RASTERIZER_SSE2)
+__m128 toBytes(__m128 values)
+{
+  const __m128 clamped = _mm_min_ps(_mm_max_ps(values, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  return _mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+}
+
+__m128 getChannels(__m128i colors, int32_t shift)
+{
+  const __m128i channels = _mm_and_si128(_mm_srli_epi32(colors, shift), _mm_set1_epi32(255));
+  return _mm_mul_ps(_mm_cvtepi32_ps(channels), _mm_set1_ps(inverse255));
+}
+
+// Same as shade() for four pixels of a textured triangle, only the texel fetches are scalar
+void shadeTextured(const Triangle& triangle,
+                   uint32_t* row,
+                   int32_t x,
+                   __m128 covered,
+                   __m128 weights1,
+                   __m128 weights2,
+                   const unsigned char* texture,
+                   bool distanceField,
+                   const float* textColor)
+{
+  const __m128 u = _mm_add_ps(_mm_add_ps(_mm_set1_ps(triangle.attributes[0]),
+                                         _mm_mul_ps(weights1, _mm_set1_ps(triangle.attributes1[0]))),
+                              _mm_mul_ps(weights2, _mm_set1_ps(triangle.attributes2[0])));
+  const __m128 v = _mm_add_ps(_mm_add_ps(_mm_set1_ps(triangle.attributes[1]),
+                                         _mm_mul_ps(weights1, _mm_set1_ps(triangle.attributes1[1]))),
+                              _mm_mul_ps(weights2, _mm_set1_ps(triangle.attributes2[1])));
+
+  const __m128 size = _mm_set1_ps(static_cast<float>(fontTextureSize));
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 s = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(u, size), half), size);
+  const __m128 t = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(v, size), half), size);
+  const __m128i texelX = _mm_cvttps_epi32(s);
+  const __m128i texelY = _mm_cvttps_epi32(t);
+  const __m128 fractionX = _mm_sub_ps(s, _mm_cvtepi32_ps(texelX));
+  const __m128 fractionY = _mm_sub_ps(t, _mm_cvtepi32_ps(texelY));
+
+  const __m128i mask = _mm_set1_epi32(fontTextureSize - 1);
+  const __m128i one = _mm_set1_epi32(1);
+  alignas(16) int32_t x0[4], y0[4], x1[4], y1[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(x0), _mm_and_si128(texelX, mask));
+  _mm_store_si128(reinterpret_cast<__m128i*>(y0), _mm_and_si128(texelY, mask));
+  _mm_store_si128(reinterpret_cast<__m128i*>(x1), _mm_and_si128(_mm_add_epi32(texelX, one), mask));
+  _mm_store_si128(reinterpret_cast<__m128i*>(y1), _mm_and_si128(_mm_add_epi32(texelY, one), mask));
+
+  alignas(16) float t00[4], t10[4], t01[4], t11[4];
+  alignas(16) uint32_t destination[4];
+  for (int32_t lane = 0; lane < 4; ++lane)
+  {
+    t00[lane] = texture[y0[lane] * fontTextureSize + x0[lane]];
+    t10[lane] = texture[y0[lane] * fontTextureSize + x1[lane]];
+    t01[lane] = texture[y1[lane] * fontTextureSize + x0[lane]];
+    t11[lane] = texture[y1[lane] * fontTextureSize + x1[lane]];
+  }
+
+  const __m128 top =
+    _mm_add_ps(_mm_load_ps(t00), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(t10), _mm_load_ps(t00)), fractionX));
+  const __m128 bottom =
+    _mm_add_ps(_mm_load_ps(t01), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(t11), _mm_load_ps(t01)), fractionX));
+  __m128 alpha =
+    _mm_mul_ps(_mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fractionY)), _mm_set1_ps(inverse255));
+
+  // Same steps as shadeDistanceField()
+  if (distanceField)
+  {
+    const __m128 scale = _mm_add_ps(_mm_add_ps(_mm_set1_ps(triangle.attributes[2]),
+                                               _mm_mul_ps(weights1, _mm_set1_ps(triangle.attributes1[2]))),
+                                    _mm_mul_ps(weights2, _mm_set1_ps(triangle.attributes2[2])));
+    const __m128 distance =
+      _mm_div_ps(_mm_sub_ps(_mm_mul_ps(alpha, _mm_set1_ps(255.0f)), _mm_set1_ps(128.0f)), _mm_set1_ps(32.0f));
+    const __m128 coverage = _mm_add_ps(_mm_mul_ps(distance, scale), _mm_set1_ps(0.5f));
+    alpha = _mm_min_ps(_mm_max_ps(coverage, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  }
+
+  // Most of a glyph quad is empty
+  const uint32_t lanes =
+    static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(covered, _mm_cmpgt_ps(alpha, _mm_setzero_ps()))));
+  if (lanes == 0u)
+  {
+    return;
+  }
+
+  for (int32_t lane = 0; lane < 4; ++lane)
+  {
+    destination[lane] = lanes & (1u << lane) ? row[x + lane] : 0u;
+  }
+
+  const __m128i colors = _mm_load_si128(reinterpret_cast<const __m128i*>(destination));
+  const __m128 inverseAlpha = _mm_sub_ps(_mm_set1_ps(1.0f), alpha);
+  const auto blendChannel = [colors, alpha, inverseAlpha](__m128 source, int32_t shift)
+  {
+    const __m128 value = _mm_add_ps(_mm_mul_ps(source, alpha), _mm_mul_ps(getChannels(colors, shift), inverseAlpha));
+    return _mm_slli_epi32(_mm_cvttps_epi32(toBytes(value)), shift);
+  };
+
+  const __m128i packed = _mm_or_si128(
+    _mm_or_si128(blendChannel(_mm_set1_ps(textColor[0]), 0), blendChannel(_mm_set1_ps(textColor[1]), 8)),
+    _mm_or_si128(blendChannel(_mm_set1_ps(textColor[2]), 16), blendChannel(_mm_set1_ps(1.0f), 24)));
+  _mm_store_si128(reinterpret_cast<__m128i*>(destination), packed);
+
+  for (int32_t lane = 0; lane < 4; ++lane)
+  {
+    if (lanes & (1u << lane))
+    {
+      row[x + lane] = destination[lane];
+    }
+  }
+}
+#endif
+
+void rasterize(const Triangle& triangle,
+               int32_t tileX,
+               int32_t tileY,
+               int32_t width,
+               int32_t height,
+               uint32_t* pixels,
+               const unsigned char* texture,
+               bool distanceField,
+               const float* textColor)
+{
+  const int32_t minX = std::max(triangle.minX, tileX << tileShift);
+  const int32_t minY = std::max(triangle.minY, tileY << tileShift);
+  const int32_t maxX = std::min({ triangle.maxX, (tileX + 1) << tileShift, width });
+  const int32_t maxY = std::min({ triangle.maxY, (tileY + 1) << tileShift, height });
+
+  const Edge* edges = triangle.edges;
+  const float lastX = static_cast<float>(maxX);
+
+  alignas(16) float weights1[4];
+  alignas(16) float weights2[4];
+
+#if defined(MODERNUI_RASTERIZER_SSE2)
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+  const __m128 inverseArea = _mm_set1_ps(triangle.inverseArea);
+  const __m128 end = _mm_set1_ps(lastX);
+
+  __m128 a[3], inclusive[3];
+  for (uint32_t index = 0u; index < 3u; ++index)
+  {
+    a[index] = _mm_set1_ps(edges[index].a);
+    inclusive[index] = _mm_castsi128_ps(_mm_set1_epi32((triangle.inclusiveEdges >> index) & 1u ? -1 : 0));
+  }
+
+  // Flat colored triangles are written four pixels at a time
+  const bool flat = !triangle.textured && triangle.attributes1[0] == 0.0f && triangle.attributes1[1] == 0.0f &&
+                    triangle.attributes1[2] == 0.0f && triangle.attributes2[0] == 0.0f &&
+                    triangle.attributes2[1] == 0.0f && triangle.attributes2[2] == 0.0f;
+  const uint32_t color = packColor(triangle.attributes[0], triangle.attributes[1], triangle.attributes[2]);
+  const __m128i flatColor = _mm_set1_epi32(static_cast<int32_t>(color));
+
+  for (int32_t y = minY; y < maxY; ++y)
+  {
+    const float centerY = static_cast<float>(y) + 0.5f;
+    float rowValues[3];
+    __m128 rowC[3];
+    for (uint32_t index = 0u; index < 3u; ++index)
+    {
+      rowValues[index] = edges[index].b * centerY + edges[index].c;
+      rowC[index] = _mm_set1_ps(rowValues[index]);
+    }
+
+    int32_t spanMinX = minX, spanMaxX = maxX;
+    if (!getRowSpan(triangle, rowValues, spanMinX, spanMaxX))
+    {
+      continue;
+    }
+
+    uint32_t* row = &pixels[static_cast<size_t>(y) * width];
+    for (int32_t x = spanMinX; x < spanMaxX; x += 4)
+    {
+      const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+      __m128 covered = _mm_cmplt_ps(centerX, end);
+      __m128 values[3];
+      for (uint32_t index = 0u; index < 3u; ++index)
+      {
+        values[index] = _mm_add_ps(_mm_mul_ps(a[index], centerX), rowC[index]);
+        const __m128 inside =
+          _mm_or_ps(_mm_cmpgt_ps(values[index], zero), _mm_and_ps(_mm_cmpeq_ps(values[index], zero), inclusive[index]));
+        covered = _mm_and_ps(covered, inside);
+      }
+
+      const uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(covered));
+      if (mask == 0u)
+      {
+        continue;
+      }
+
+      if (flat && mask == 15u)
+      {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&row[x]), flatColor);
+        continue;
+      }
+
+      if (triangle.textured)
+      {
+        shadeTextured(triangle, row, x, covered, _mm_mul_ps(values[1], inverseArea), _mm_mul_ps(values[2], inverseArea),
+                      texture, distanceField, textColor);
+        continue;
+      }
+
+      _mm_store_ps(weights1, _mm_mul_ps(values[1], inverseArea));
+      _mm_store_ps(weights2, _mm_mul_ps(values[2], inverseArea));
+      shade(triangle, row, x, mask, weights1, weights2, texture, distanceField, textColor);
+    }
+  }
+#else
+  for (int32_t y = minY; y < maxY; ++y)
+  {
+    const float centerY = static_cast<float>(y) + 0.5f;
+    float rowC[3];
+    for (uint32_t index = 0u; index < 3u; ++index)
+    {
+      rowC[index] = edges[index].b * centerY + edges[index].c;
+    }
+
+    int32_t spanMinX = minX, spanMaxX = maxX;
+    if (!getRowSpan(triangle, rowC, spanMinX, spanMaxX))
+    {
+      continue;
+    }
+
+    uint32_t* row = &pixels[static_cast<size_t>(y) * width];
+    for (int32_t x = spanMinX; x < spanMaxX; x += 4)
+    {
+      uint32_t mask = 0u;
+      for (int32_t lane = 0; lane < 4; ++lane)
+      {
+        const float centerX = static_cast<float>(x) + (static_cast<float>(lane) + 0.5f);
+        bool covered = centerX < lastX;
+        float values[3];
+        for (uint32_t index = 0u; index < 3u; ++index)
+        {
+          values[index] = edges[index].a * centerX + rowC[index];
+          covered &= values[index] > 0.0f || (values[index] == 0.0f && ((triangle.inclusiveEdges >> index) & 1u));
+        }
+
+        weights1[lane] = values[1] * triangle.inverseArea;
+        weights2[lane] = values[2] * triangle.inverseArea;
+        mask |= covered ? 1u << lane : 0u;
+      }
+
+      if (mask != 0u)
+      {
+        shade(triangle, row, x, mask, weights1, weights2, texture, distanceField, textColor);
+      }
+    }
+  }
+#endif
+}
+} // namespace
+
+struct Rasterizer::Data final
+{
+  int32_t width, height;
+  int32_t numTilesX, numTilesY;
+  std::vector<uint32_t> pixels;
+  float textColor[3] = { 0.3f, 0.3f, 0.3f };
+
+  ThreadPool threadPool;
+
+  std::vector<Chunk> chunks;
+  std::vector<ColorVertex> expandedRectangles;
+
+  // What the current draw reads from
+  const ColorVertex* colorVertices = nullptr;
+  const TextureVertex* textureVertices = nullptr;
+  const unsigned char* texture = nullptr;
+  bool distanceField = false;
+  const void* indices = nullptr;
+  Context::IndexType indexType = Context::IndexType::None;
+  bool colorsIndexed = false, texturesIndexed = false;
+  size_t numTriangles = 0u, numChunks = 0u;
+
+  // Triangles of the draw are numbered across the ranges, every range ends where the next one starts
+  std::vector<TriangleRange> ranges;
+  std::vector<size_t> rangeEnds;
+
+  Data(int32_t width, int32_t height, size_t numThreads)
+  : width(std::max(width, 0))
+  , height(std::max(height, 0))
+  , numTilesX((this->width + tileSize - 1) >> tileShift)
+  , numTilesY((this->height + tileSize - 1) >> tileShift)
+  , pixels(static_cast<size_t>(this->width) * this->height, 0u)
+  , threadPool(std::max(numThreads, size_t(1u)))
+  {
+  }
+
+  size_t getNumTiles() const
+  {
+    return static_cast<size_t>(numTilesX) * numTilesY;
+  }
+
+  size_t getVertexIndex(size_t index) const
+  {
+    if (indexType == Context::IndexType::UInt16)
+    {
+      const size_t indicesPerBatch = maxQuadsPerUInt16Batch * indicesPerQuad;
+      const size_t batch = index / indicesPerBatch;
+      const uint16_t* indices16 = static_cast<const uint16_t*>(indices);
+      return batch * maxQuadsPerUInt16Batch * verticesPerIndexedQuad + indices16[index % indicesPerBatch];
+    }
+
+    return static_cast<const uint32_t*>(indices)[index];
+  }
+
+  // The index is the one of the triangle in its stream
+  void getTriangle(bool textured, size_t index, Vertex* vertices) const
+  {
+    for (size_t corner = 0u; corner < 3u; ++corner)
+    {
+      Vertex& vertex = vertices[corner];
+      const size_t element = index * 3u + corner;
+      if (textured)
+      {
+        const TextureVertex& source = textureVertices[texturesIndexed ? getVertexIndex(element) : element];
+        vertex = { source.getX(), source.getY(), { source.getU(), source.getV(), source.getScale() } };
+      }
+      else
+      {
+        const ColorVertex& source = colorVertices[colorsIndexed ? getVertexIndex(element) : element];
+        vertex = { source.getX(), source.getY(), { source.getR(), source.getG(), source.getB() } };
+      }
+    }
+  }
+
+  // Vertex ranges of indexed streams are whole quads, whose triangles are six indices apart
+  void addRange(bool textured, size_t firstVertex, size_t numVertices)
+  {
+    const bool indexed = textured ? texturesIndexed : colorsIndexed;
+    const size_t firstTriangle = indexed ? firstVertex / verticesPerIndexedQuad * 2u : firstVertex / 3u;
+    const size_t numRangeTriangles = indexed ? numVertices / verticesPerIndexedQuad * 2u : numVertices / 3u;
+    if (numRangeTriangles == 0u)
+    {
+      return;
+    }
+
+    numTriangles += numRangeTriangles;
+    ranges.push_back({ textured, firstTriangle, numRangeTriangles });
+    rangeEnds.push_back(numTriangles);
+  }
+
+  void binChunk(size_t chunkIndex)
+  {
+    Chunk& chunk = chunks[chunkIndex];
+    chunk.triangles.clear();
+    chunk.entries.clear();
+
+    const size_t first = chunkIndex * trianglesPerChunk;
+    const size_t last = std::min(first + trianglesPerChunk, numTriangles);
+    size_t range = std::upper_bound(rangeEnds.begin(), rangeEnds.end(), first) - rangeEnds.begin();
+    for (size_t index = first; index < last; ++index)
+    {
+      if (index == rangeEnds[range])
+      {
+        ++range;
+      }
+
+      const TriangleRange& triangleRange = ranges[range];
+      const size_t rangeStart = rangeEnds[range] - triangleRange.numTriangles;
+
+      Vertex vertices[3];
+      getTriangle(triangleRange.textured, triangleRange.firstTriangle + index - rangeStart, vertices);
+
+      Triangle triangle;
+      if (!setup(vertices[0], vertices[1], vertices[2], triangleRange.textured, width, height, triangle))
+      {
+        continue;
+      }
+
+      const uint32_t triangleIndex = static_cast<uint32_t>(chunk.triangles.size());
+      for (int32_t tileY = triangle.minY >> tileShift; tileY <= (triangle.maxY - 1) >> tileShift; ++tileY)
+      {
+        for (int32_t tileX = triangle.minX >> tileShift; tileX <= (triangle.maxX - 1) >> tileShift; ++tileX)
+        {
+          if (overlapsTile(triangle, tileX, tileY))
+          {
+            const uint64_t tile = static_cast<uint64_t>(tileY) * numTilesX + tileX;
+            chunk.entries.push_back(tile << 32 | triangleIndex);
+          }
+        }
+      }
+
+      chunk.triangles.push_back(triangle);
+    }
+
+    // Counting sort by tile, which keeps the triangles of every tile in order
+    const size_t numTiles = getNumTiles();
+    std::vector<uint32_t>& firstEntries = chunk.firstEntries;
+    firstEntries.assign(numTiles + 1u, 0u);
+    for (const uint64_t entry : chunk.entries)
+    {
+      ++firstEntries[(entry >> 32) + 1u];
+    }
+
+    for (size_t tile = 0u; tile < numTiles; ++tile)
+    {
+      firstEntries[tile + 1u] += firstEntries[tile];
+    }
+
+    chunk.binnedTriangles.resize(chunk.entries.size());
+    for (const uint64_t entry : chunk.entries)
+    {
+      chunk.binnedTriangles[firstEntries[entry >> 32]++] = static_cast<uint32_t>(entry);
+    }
+
+    // Filling moved every offset to the start of the next tile
+    for (size_t tile = numTiles; tile > 0u; --tile)
+    {
+      firstEntries[tile] = firstEntries[tile - 1u];
+    }
+
+    firstEntries[0] = 0u;
+  }
+
+  void shadeTile(size_t tile)
+  {
+    const int32_t tileX = static_cast<int32_t>(tile % numTilesX);
+    const int32_t tileY = static_cast<int32_t>(tile / numTilesX);
+    for (size_t chunkIndex = 0u; chunkIndex < numChunks; ++chunkIndex)
+    {
+      const Chunk& chunk = chunks[chunkIndex];
+      for (uint32_t entry = chunk.firstEntries[tile]; entry < chunk.firstEntries[tile + 1u]; ++entry)
+      {
+        rasterize(chunk.triangles[chunk.binnedTriangles[entry]], tileX, tileY, width, height, pixels.data(), texture,
+                  distanceField, textColor);
+      }
+    }
+  }
+};
+
+Rasterizer::Rasterizer(int32_t width, int32_t height, size_t numThreads)
+: d(std::make_unique<Data>(width, height, numThreads))
+{
+}
+
+Rasterizer::~Rasterizer() = default;
+
+int32_t Rasterizer::getWidth() const
+{
+  return d->width;
+}
+
+int32_t Rasterizer::getHeight() const
+{
+  return d->height;
+}
+
+void Rasterizer::setTextColor(float r, float g, float b)
+{
+  d->textColor[0] = r;
+  d->textColor[1] = g;
+  d->textColor[2] = b;
+}
+
+void Rasterizer::clear(float r, float g, float b)
+{
+  std::fill(d->pixels.begin(), d->pixels.end(), packColor(r, g, b));
+}
+
+void Rasterizer::draw(const Context& context)
+{
+  if (d->pixels.empty())
+  {
+    return;
+  }
+
+  d->colorVertices = context.getColorVertices();
+  size_t numColorVertices = context.getNumColorVertices();
+  if (context.getInstancedRectangles())
+  {
+    const size_t numInstances = context.getNumRectangleInstances();
+    d->expandedRectangles.resize(numInstances * 6u);
+    expandRectangleInstances(context.getRectangleInstances(), numInstances, d->expandedRectangles.data());
+    d->colorVertices = d->expandedRectangles.data();
+    numColorVertices = d->expandedRectangles.size();
+  }
+
+  d->textureVertices = context.getTextureVertices();
+  d->texture = context.getFontTextureData();
+  d->distanceField = context.getDistanceFieldText();
+
+  // Both streams share the index buffer, instanced rectangles are never indexed
+  d->indices = context.getIndices();
+  d->indexType = context.getIndexType();
+  d->colorsIndexed = d->indexType != Context::IndexType::None && !context.getInstancedRectangles();
+  d->texturesIndexed = d->indexType != Context::IndexType::None;
+
+  d->numTriangles = 0u;
+  d->ranges.clear();
+  d->rangeEnds.clear();
+  if (context.getDrawList())
+  {
+    for (size_t index = 0u; index < context.getNumDrawCommands(); ++index)
+    {
+      const DrawCommand& command = context.getDrawCommands()[index];
+      if (command.pipeline == DrawCommand::Pipeline::Rectangle)
+      {
+        d->addRange(false, command.first * 6u, command.count * 6u);
+      }
+      else
+      {
+        d->addRange(command.pipeline == DrawCommand::Pipeline::Text, command.first, command.count);
+      }
+    }
+  }
+  else
+  {
+    d->addRange(false, 0u, numColorVertices);
+    d->addRange(true, 0u, context.getNumTextureVertices());
+  }
+
+  d->numChunks = (d->numTriangles + trianglesPerChunk - 1u) / trianglesPerChunk;
+  if (d->chunks.size() < d->numChunks)
+  {
+    d->chunks.resize(d->numChunks);
+  }
+
+  d->threadPool.run(d->numChunks, [this](size_t chunk) { d->binChunk(chunk); });
+  d->threadPool.run(d->getNumTiles(), [this](size_t tile) { d->shadeTile(tile); });
+}
+
+const uint32_t* Rasterizer::getPixels() const
+{
+  return d->pixels.data();
+}
+} // namespace ModernUI
@@ -4,12 +4,13 @@ namespace ModernUI
 {
 struct Button::Data final
 {
+  uint32_t revision = 0u;
   std::string text;
   int32_t x, y;
   int32_t width, height;
 };
 
-Button::Button(const std::string& text, int32_t x, int32_t y, int32_t width, int32_t height) : d(new Data)
+Button::Button(std::string_view text, int32_t x, int32_t y, int32_t width, int32_t height) : d(new Data)
 {
   setText(text);
   setPosition(x, y);
@@ -18,13 +19,19 @@ Button::Button(const std::string& text, int32_t x, int32_t y, int32_t width, int
 
 Button::~Button() = default;
 
-std::string Button::getText() const
+uint32_t Button::getRevision() const
+{
+  return d->revision;
+}
+
+std::string_view Button::getText() const
 {
   return d->text;
 }
 
-void Button::setText(const std::string& text)
+void Button::setText(std::string_view text)
 {
+  ++d->revision;
   d->text = text;
 }
 
@@ -40,6 +47,7 @@ int32_t Button::getY() const
 
 void Button::setPosition(int32_t x, int32_t y)
 {
+  ++d->revision;
   d->x = x;
   d->y = y;
 }
@@ -56,6 +64,7 @@ int32_t Button::getHeight() const
 
 void Button::setSize(int32_t width, int32_t height)
 {
+  ++d->revision;
   d->width = width;
   d->height = height;
 }
@@ -0,0 +1,164 @@
+#include "CommandQueue.h"
+
+#include <memory>
+#include <new>
+
+namespace ModernUI
+{
+namespace
+{
+constexpr uint64_t indexMask = 0xFFFFFFFFull;
+} // namespace
+
+Command::Command(std::pmr::memory_resource* resource) : text(resource)
+{
+}
+
+CommandQueue::CommandQueue(std::pmr::memory_resource* resource) : resource(resource)
+{
+}
+
+CommandQueue::~CommandQueue()
+{
+  std::pmr::polymorphic_allocator<Command> allocator(resource);
+  for (Command* command = take(); command;)
+  {
+    Command* const next = command->next;
+    if (command->index == 0u)
+    {
+      allocator.delete_object(command);
+    }
+
+    command = next;
+  }
+
+  for (uint32_t block = 0u; block < numBlocks; ++block)
+  {
+    Command* const commands = blocks[block].load(std::memory_order_relaxed);
+    std::destroy_n(commands, commandsPerBlock);
+    allocator.deallocate(commands, commandsPerBlock);
+  }
+}
+
+Command* CommandQueue::allocate(Command::Type type, uint32_t slot, uint32_t generation)
+{
+  Command* command = nullptr;
+
+  // Acquires the commands that the taking thread put back, and the blocks they are in
+  uint64_t head = freeList.load(std::memory_order_acquire);
+  while ((head & indexMask) != 0u)
+  {
+    Command& first = getPooled(static_cast<uint32_t>(head & indexMask));
+    const uint64_t next = ((head >> 32u) + 1u) << 32u | first.nextFree.load(std::memory_order_relaxed);
+    if (freeList.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+    {
+      command = &first;
+      break;
+    }
+  }
+
+  if (!command)
+  {
+    command = std::pmr::polymorphic_allocator<Command>(resource).new_object<Command>(resource);
+  }
+
+  command->type = type;
+  command->slot = slot;
+  command->generation = generation;
+  return command;
+}
+
+void CommandQueue::push(Command* command)
+{
+  // Releases the command to the thread that takes it, nothing is ever popped so the head can not come back as ABA
+  command->next = pending.load(std::memory_order_relaxed);
+  while (!pending.compare_exchange_weak(command->next, command, std::memory_order_release, std::memory_order_relaxed))
+  {
+  }
+}
+
+Command* CommandQueue::take()
+{
+  Command* command = pending.exchange(nullptr, std::memory_order_acquire);
+
+  Command* oldest = nullptr;
+  while (command)
+  {
+    Command* const next = command->next;
+    command->next = oldest;
+    oldest = command;
+    command = next;
+  }
+
+  return oldest;
+}
+
+void CommandQueue::recycle(Command* commands)
+{
+  // Allocated commands are freed and replaced by pooled ones, so that the pool only stops growing once it is large enough
+  std::pmr::polymorphic_allocator<Command> allocator(resource);
+  size_t numAllocated = 0u;
+  uint32_t first = 0u;
+  Command* last = nullptr;
+  while (commands)
+  {
+    Command* const command = commands;
+    commands = command->next;
+    command->next = nullptr;
+    if (command->index == 0u)
+    {
+      allocator.delete_object(command);
+      ++numAllocated;
+      continue;
+    }
+
+    command->nextFree.store(first, std::memory_order_relaxed);
+    first = command->index;
+    if (!last)
+    {
+      last = command;
+    }
+  }
+
+  if (last)
+  {
+    // Releases the commands to the next thread that takes them off the list
+    uint64_t head = freeList.load(std::memory_order_relaxed);
+    do
+    {
+      last->nextFree.store(static_cast<uint32_t>(head & indexMask), std::memory_order_relaxed);
+    } while (!freeList.compare_exchange_weak(head, (head & ~indexMask) | first, std::memory_order_release,
+                                             std::memory_order_relaxed));
+  }
+
+  if (numAllocated > 0u)
+  {
+    grow(numAllocated);
+  }
+}
+
+Command& CommandQueue::getPooled(uint32_t index) const
+{
+  const uint32_t position = index - 1u;
+  return blocks[position / commandsPerBlock].load(std::memory_order_relaxed)[position % commandsPerBlock];
+}
+
+void CommandQueue::grow(size_t numCommands)
+{
+  std::pmr::polymorphic_allocator<Command> allocator(resource);
+  const size_t numNewBlocks = (numCommands + commandsPerBlock - 1u) / commandsPerBlock;
+  for (size_t block = 0u; block < numNewBlocks && numBlocks < maxBlocks; ++block)
+  {
+    Command* const newCommands = allocator.allocate(commandsPerBlock);
+    for (uint32_t index = 0u; index < commandsPerBlock; ++index)
+    {
+      Command* const command = new (&newCommands[index]) Command(resource);
+      command->index = numBlocks * commandsPerBlock + index + 1u;
+      command->next = index + 1u < commandsPerBlock ? &newCommands[index + 1u] : nullptr;
+    }
+
+    blocks[numBlocks++].store(newCommands, std::memory_order_relaxed);
+    recycle(newCommands);
+  }
+}
+} // namespace ModernUI
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+namespace ModernUI
+{
+// A change to one property of a widget in a context, identified by the slot and generation of its handle
+struct Command final
+{
+  enum class Type
+  {
+    WindowPosition,
+    WindowSize,
+    WindowColor,
+    ButtonText,
+    ButtonPosition,
+    ButtonSize
+  };
+
+  explicit Command(std::pmr::memory_resource* resource);
+
+  Type type = Type::WindowPosition;
+  uint32_t slot = 0u;
+  uint32_t generation = 0u;
+
+  // A position or a size, depending on the type
+  int32_t x = 0, y = 0;
+
+  float r = 0.0f, g = 0.0f, b = 0.0f;
+
+  // Keeps its capacity when the command is reused
+  std::pmr::string text;
+
+  Command* next = nullptr;
+
+  // Pooled commands are numbered from one, zero marks commands that were allocated because the pool was empty. The
+  // next free command is read by threads that may lose the race for this one, so it is atomic.
+  uint32_t index = 0u;
+  std::atomic<uint32_t> nextFree{ 0u };
+};
+
+// Commands that any number of threads push without blocking and one thread takes. Pushing prepends to a lock-free list
+// with a compare and swap, taking detaches the whole list at once and reverses it into the order it was pushed in.
+// Commands come from a pool with a lock-free free list, which the taking thread refills and grows to the most commands
+// that were ever pending at once.
+class CommandQueue final
+{
+public:
+  explicit CommandQueue(std::pmr::memory_resource* resource);
+  ~CommandQueue();
+
+  CommandQueue(const CommandQueue&) = delete;
+  CommandQueue& operator=(const CommandQueue&) = delete;
+
+  // Returns a command to fill in and push, from the pool or allocated if the pool is empty. Can be called from any
+  // thread.
+  Command* allocate(Command::Type type, uint32_t slot, uint32_t generation);
+  void push(Command* command);
+
+  // Returns every command pushed so far, oldest first. Only one thread may take commands, it owns them until it
+  // recycles them.
+  Command* take();
+  void recycle(Command* commands);
+
+private:
+  static constexpr uint32_t commandsPerBlock = 256u;
+  static constexpr uint32_t maxBlocks = 256u;
+
+  Command& getPooled(uint32_t index) const;
+  void grow(size_t numCommands);
+
+  std::pmr::memory_resource* resource;
+  std::atomic<Command*> pending{ nullptr };
+
+  // The index of the first free command in the lower half, and a tag in the upper half that changes whenever a command
+  // is taken off the list. A thread that read the list before someone else took its first command and put it back
+  // then fails its compare and swap instead of linking in a command that is in use.
+  std::atomic<uint64_t> freeList{ 0u };
+
+  // Blocks are only added by the thread that takes commands, and only ever read for commands that were on the free list
+  std::atomic<Command*> blocks[maxBlocks] = {};
+  uint32_t numBlocks = 0u;
+};
+} // namespace ModernUI
@@ -1,172 +1,3016 @@
+#include "CommandQueue.h"
+#include "FontData.h"
+#include "GlyphAtlas.h"
+#include "Kernels.h"
+#include "Layout.h"
 #include "ModernUI.h"
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+#include "Utf8.h"
+#include "WidgetStorage.h"
+#include "WidgetTree.h"
 
-#define STB_TRUETYPE_IMPLEMENTATION
-#define STBTT_STATIC
 #include <stb/stb_truetype.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace ModernUI
 {
+namespace
+{
+constexpr char defaultFontPath[] = "C:\\Users\\janhs\\dev\\modernui-build\\src\\Debug\\Arial.ttf";
+
+constexpr size_t verticesPerQuad = 6u;
+constexpr size_t verticesPerIndexedQuad = 4u;
+
+// Frames with more damaged widgets report the bounds of all of them instead
+constexpr size_t maxDamageRects = 32u;
+
+// Largest number of quads that 16-bit indices can address without a base vertex
+constexpr size_t maxQuadsPerUInt16Batch = 65536u / verticesPerIndexedQuad;
+
+// Spare capacity given to label ranges in retained mode, so that small text edits do not move other ranges
+constexpr size_t labelGlyphGranularity = 8u;
+
+// Rectangle of a widget that was not laid out yet
+constexpr size_t noRectangle = SIZE_MAX;
+
+// Frames are processed in chunks of this many consecutive slots, which do not depend on the number of threads
+constexpr uint32_t slotsPerChunk = 1024u;
+
+// Widgets whose uncovered part splits into more pieces than this are treated as visible
+constexpr size_t maxUncoveredRects = 64u;
+
+// Covering boxes are mostly small, so their grid has cells of 64 pixels
+constexpr int32_t coverageCellShift = 6;
+
+bool isSupportedCharacter(char c)
+{
+  return c >= 32u && c < 128u;
+}
+
+// Writes two triangles, or the four unique corners when indexed, and returns the vertex after the quad
+template<typename Vertex>
+Vertex* writeQuad(Vertex* vertices,
+                  bool indexed,
+                  const Vertex& topLeft,
+                  const Vertex& topRight,
+                  const Vertex& bottomLeft,
+                  const Vertex& bottomRight)
+{
+  *vertices++ = topLeft;
+  *vertices++ = topRight;
+  *vertices++ = bottomLeft;
+
+  if (!indexed)
+  {
+    *vertices++ = topRight;
+    *vertices++ = bottomLeft;
+  }
+
+  *vertices++ = bottomRight;
+  return vertices;
+}
+
+// Grows an index buffer holding the pattern 0, 1, 2, 1, 2, 3 for every quad
+template<typename Index>
+void growQuadIndices(std::pmr::vector<Index>& indices, size_t numQuads)
+{
+  size_t quad = indices.size() / 6u;
+  if (quad >= numQuads)
+  {
+    return;
+  }
+
+  indices.resize(numQuads * 6u);
+  for (; quad < numQuads; ++quad)
+  {
+    const Index first = static_cast<Index>(quad * verticesPerIndexedQuad);
+    Index* index = &indices[quad * 6u];
+    index[0] = first;
+    index[1] = first + 1u;
+    index[2] = first + 2u;
+    index[3] = first + 1u;
+    index[4] = first + 2u;
+    index[5] = first + 3u;
+  }
+}
+
+// Trims quads to a box, quads entirely outside of it collapse into degenerate triangles
+void clipQuads(TextureVertex* vertices, size_t numVertices, bool indexed, const Rect& box)
+{
+  const size_t quadSize = indexed ? verticesPerIndexedQuad : verticesPerQuad;
+  const float left = static_cast<float>(box.x);
+  const float top = static_cast<float>(box.y);
+  const float right = static_cast<float>(box.x + box.width);
+  const float bottom = static_cast<float>(box.y + box.height);
+
+  for (TextureVertex* quad = vertices; quad != vertices + numVertices; quad += quadSize)
+  {
+    const float quadLeft = quad[0].getX();
+    const float quadTop = quad[0].getY();
+    const float quadRight = quad[quadSize - 1u].getX();
+    const float quadBottom = quad[quadSize - 1u].getY();
+    if (quadLeft >= left && quadTop >= top && quadRight <= right && quadBottom <= bottom)
+    {
+      continue;
+    }
+
+    const float x0 = std::max(quadLeft, left);
+    const float y0 = std::max(quadTop, top);
+    const float x1 = std::min(quadRight, right);
+    const float y1 = std::min(quadBottom, bottom);
+    if (x0 >= x1 || y0 >= y1)
+    {
+      std::fill(quad, quad + quadSize, TextureVertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f));
+      continue;
+    }
+
+    // Texture coordinates are linear across the quad
+    const float uLeft = quad[0].getU();
+    const float vTop = quad[0].getV();
+    const float uPerX = (quad[quadSize - 1u].getU() - uLeft) / (quadRight - quadLeft);
+    const float vPerY = (quad[quadSize - 1u].getV() - vTop) / (quadBottom - quadTop);
+    const float u0 = uLeft + (x0 - quadLeft) * uPerX;
+    const float v0 = vTop + (y0 - quadTop) * vPerY;
+    const float u1 = uLeft + (x1 - quadLeft) * uPerX;
+    const float v1 = vTop + (y1 - quadTop) * vPerY;
+    const float scale = quad[0].getScale();
+
+    // clang-format off
+    writeQuad<TextureVertex>(quad, indexed,
+                             { x0, y0, u0, v0, scale },
+                             { x1, y0, u1, v0, scale },
+                             { x0, y1, u0, v1, scale },
+                             { x1, y1, u1, v1, scale });
+    // clang-format on
+  }
+}
+
+bool isEmpty(const Rect& rect)
+{
+  return rect.width <= 0 || rect.height <= 0;
+}
+
+// Empty rectangles are ignored
+Rect getUnion(const Rect& a, const Rect& b)
+{
+  if (isEmpty(a))
+  {
+    return b;
+  }
+  else if (isEmpty(b))
+  {
+    return a;
+  }
+
+  const int32_t left = std::min(a.x, b.x);
+  const int32_t top = std::min(a.y, b.y);
+  const int32_t right = std::max(a.x + a.width, b.x + b.width);
+  const int32_t bottom = std::max(a.y + a.height, b.y + b.height);
+  return { left, top, right - left, bottom - top };
+}
+
+Rect getIntersection(const Rect& a, const Rect& b)
+{
+  const int32_t left = std::max(a.x, b.x);
+  const int32_t top = std::max(a.y, b.y);
+  const int32_t right = std::min(a.x + a.width, b.x + b.width);
+  const int32_t bottom = std::min(a.y + a.height, b.y + b.height);
+  return { left, top, std::max(right - left, 0), std::max(bottom - top, 0) };
+}
+
+// Appends the parts of a rectangle that lie outside of another one, at most four of them
+void subtractRect(const Rect& rect, const Rect& cover, std::pmr::vector<Rect>& result)
+{
+  const Rect overlap = getIntersection(rect, cover);
+  if (isEmpty(overlap))
+  {
+    result.push_back(rect);
+    return;
+  }
+
+  // Strips above and below the overlap span the whole width, the ones beside it only its height
+  const int32_t right = rect.x + rect.width;
+  const int32_t bottom = rect.y + rect.height;
+  const int32_t overlapRight = overlap.x + overlap.width;
+  const int32_t overlapBottom = overlap.y + overlap.height;
+  if (overlap.y > rect.y)
+  {
+    result.push_back({ rect.x, rect.y, rect.width, overlap.y - rect.y });
+  }
+
+  if (overlapBottom < bottom)
+  {
+    result.push_back({ rect.x, overlapBottom, rect.width, bottom - overlapBottom });
+  }
+
+  if (overlap.x > rect.x)
+  {
+    result.push_back({ rect.x, overlap.y, overlap.x - rect.x, overlap.height });
+  }
+
+  if (overlapRight < right)
+  {
+    result.push_back({ overlapRight, overlap.y, right - overlapRight, overlap.height });
+  }
+}
+
+double getMilliseconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Returns one if a vector grew beyond the capacity it had before
+template<typename T>
+size_t countReallocation(const std::pmr::vector<T>& vector, size_t capacity)
+{
+  return vector.capacity() != capacity ? 1u : 0u;
+}
+
+void addRange(std::pmr::vector<ByteRange>& ranges, size_t offset, size_t size)
+{
+  if (size == 0u)
+  {
+    return;
+  }
+
+  // Merge with the previous range if they touch
+  if (!ranges.empty() && ranges.back().offset + ranges.back().size == offset)
+  {
+    ranges.back().size += size;
+    return;
+  }
+
+  ranges.push_back({ offset, size });
+}
+} // namespace
+
 struct Context::Data final
 {
-  Context::Error error;
+  // Output of one chunk, the ranges of all chunks are merged in order after they finished
+  struct Chunk final
+  {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    explicit Chunk(const allocator_type& allocator)
+    : rectangleBatch(allocator), colorVertexRanges(allocator), textureVertexRanges(allocator),
+      rectangleInstanceRanges(allocator)
+    {
+    }
+
+    Chunk(const Chunk& other, const allocator_type& allocator) : Chunk(allocator)
+    {
+      *this = other;
+    }
+
+    Chunk(Chunk&& other, const allocator_type& allocator) : Chunk(allocator)
+    {
+      *this = std::move(other);
+    }
+
+    size_t numRectangles, firstRectangle;
+    size_t numTextureVertices, firstTextureVertex;
+
+    // Chunks without visible widgets are skipped once their ranges were given up
+    bool culled = false;
+    bool hasRanges = false;
+
+    // Rectangles are expanded in batches of consecutive ones
+    std::pmr::vector<RectangleInput> rectangleBatch;
+    size_t firstBatchedRectangle = 0u;
+
+    std::pmr::vector<ByteRange> colorVertexRanges;
+    std::pmr::vector<ByteRange> textureVertexRanges;
+    std::pmr::vector<ByteRange> rectangleInstanceRanges;
+
+    // Added to the stats of the frame in chunk order
+    FrameStats stats;
+  };
+
+  struct WindowSlot final
+  {
+    uint32_t revision = 0u;
+    size_t rectangle = noRectangle;
+    bool visible = true;
+    bool occluded = false;
+    Rect drawnBounds = { 0, 0, 0, 0 };
+  };
+
+  struct ButtonSlot final
+  {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    explicit ButtonSlot(const allocator_type& allocator) : labelText(allocator), labelVertices(allocator)
+    {
+    }
+
+    ButtonSlot(const ButtonSlot& other, const allocator_type& allocator) : ButtonSlot(allocator)
+    {
+      *this = other;
+    }
+
+    ButtonSlot(ButtonSlot&& other, const allocator_type& allocator) : ButtonSlot(allocator)
+    {
+      *this = std::move(other);
+    }
+
+    uint32_t revision = 0u;
+    size_t rectangle = noRectangle;
+    bool visible = true;
+    bool occluded = false;
+    size_t firstTextureVertex;
+    size_t numTextureVertices;
+
+    // Label quads relative to the label origin, reused until the text or the glyphs change
+    std::pmr::string labelText;
+    uint32_t labelGeneration = 0u;
+    std::pmr::vector<TextureVertex> labelVertices;
+    Rect labelBounds = { 0, 0, 0, 0 };
+    size_t numDroppedGlyphs = 0u;
+
+    // Including the label when it is not clipped
+    Rect drawnBounds = { 0, 0, 0, 0 };
+  };
+
+  // Every container of a context allocates from its resource
+  std::pmr::memory_resource* resource;
+
+  Context::Error error;
+
+  WindowStorage windows{ resource };
+  ButtonStorage buttons{ resource };
+  std::pmr::vector<ColorVertex> colorVertices{ resource };
+  std::pmr::vector<TextureVertex> textureVertices{ resource };
+
+  // Command stuff, other threads only ever touch the queue
+  CommandQueue commandQueue{ resource };
+
+  // Hierarchy stuff, only widgets with a parent or children are in the tree
+  WidgetTree tree{ resource };
+  Layout widgetLayout{ tree, windows, buttons, resource };
+  std::pmr::vector<uint32_t> resolvedNodes{ resource };
+
+  // Output stuff, vertices go into the buffers of the caller if they are large enough and into the vectors above
+  // otherwise
+  bool hasOutputBuffers = false;
+  bool outputOverflow = false;
+  OutputBuffers outputBuffers;
+  ColorVertex* colorOutput = nullptr;
+  TextureVertex* textureOutput = nullptr;
+  RectangleInstance* rectangleOutput = nullptr;
+  size_t numColorVertices = 0u;
+  size_t numTextureVertices = 0u;
+  size_t numRectangleInstances = 0u;
+
+  // Indexed mode stuff, the index pattern is the same for every quad and shared by both vertex streams
+  IndexType indexType = IndexType::None;
+  std::pmr::vector<uint16_t> indices16{ resource };
+  std::pmr::vector<uint32_t> indices32{ resource };
+
+  InstructionSet instructionSet;
+  const Kernels* kernels;
+
+  // Multithreading stuff, without a pool or an executor the chunks run one after the other on the calling thread
+  std::pmr::vector<Chunk> chunks{ resource };
+  std::unique_ptr<ThreadPool> threadPool;
+  TaskExecutor taskExecutor;
+
+  // Instancing stuff
+  bool instancedRectangles = false;
+  std::pmr::vector<RectangleInstance> rectangleInstances{ resource };
+  std::pmr::vector<ByteRange> rectangleInstanceRanges{ resource };
+
+  // Draw list stuff, widgets are stacked by their drawn bounds in draw order and numbered as nodes of the tree
+  bool drawList = false;
+  bool drawListDirty = false;
+  SpatialGrid layerGrid{ resource };
+  std::pmr::vector<uint32_t> nodeLayers{ resource };
+  std::pmr::vector<DrawCommand> unsortedDrawCommands{ resource };
+  std::pmr::vector<uint32_t> drawOrder{ resource };
+  std::pmr::vector<DrawCommand> drawCommands{ resource };
+
+  // Retained mode stuff
+  bool retainedMode = false;
+  bool layoutDirty = true;
+  bool rewriteAll = true;
+  std::pmr::vector<WindowSlot> windowSlots{ resource };
+  std::pmr::vector<ButtonSlot> buttonSlots{ resource };
+  std::pmr::vector<ByteRange> colorVertexRanges{ resource };
+  std::pmr::vector<ByteRange> textureVertexRanges{ resource };
+
+  // Culling stuff, the grids index the slots of live widgets once they are needed
+  bool hasViewport = false;
+  Rect viewport;
+  bool spatialIndex = false;
+  SpatialGrid windowGrid{ resource };
+  SpatialGrid buttonGrid{ resource };
+  std::pmr::vector<uint32_t> visibleWindows{ resource };
+  std::pmr::vector<uint32_t> visibleButtons{ resource };
+  std::pmr::vector<uint32_t> queryResult{ resource };
+  std::pmr::vector<WidgetHandle> foundWidgets{ resource };
+
+  // Occlusion stuff, widgets are tested front to back against the union of the opaque boxes in front of them. Slots
+  // that overlap the viewport are candidates for being visible.
+  bool occlusionCulling = false;
+  bool occlusionDirty = false;
+  std::pmr::vector<uint32_t> candidateWindows{ resource };
+  std::pmr::vector<uint32_t> candidateButtons{ resource };
+  SpatialGrid coverageGrid{ resource, coverageCellShift };
+  std::pmr::vector<Rect> coverageRects{ resource };
+  std::pmr::vector<Rect> uncoveredRects{ resource };
+  std::pmr::vector<Rect> remainingRects{ resource };
+  std::pmr::vector<uint32_t> occludedNodes{ resource };
+  std::pmr::vector<uint32_t> previousOccludedNodes{ resource };
+  std::pmr::vector<uint32_t> occlusionChangedNodes{ resource };
+
+  // Input stuff, every queued event holds the whole pointer state after it
+  struct PointerEvent final
+  {
+    int32_t x, y;
+    bool down;
+  };
+
+  std::pmr::vector<PointerEvent> pointerEvents{ resource };
+  PointerEvent pointer = { 0, 0, false };
+  WidgetHandle hoveredWidget;
+  WidgetHandle pressedWidget;
+  std::pmr::vector<WidgetHandle> clickedWidgets{ resource };
+
+  // Font stuff, the glyph atlas of a context writes into its own texture since the font is shared. Distance field text
+  // always goes through the glyph atlas.
+  std::shared_ptr<const Font> font;
+  std::pmr::vector<unsigned char> fontBitmap{ resource };
+  bool dynamicGlyphs = false;
+  bool distanceFieldText = false;
+  float textScale = 1.0f;
+  std::unique_ptr<GlyphAtlas> glyphAtlas;
+  uint32_t glyphAtlasGeneration = 0u;
+  bool fontTextureDirty = false;
+  std::pmr::vector<Rect> fontTextureRegions{ resource };
+
+  // Increased whenever cached labels may refer to stale glyphs or use the wrong vertex layout
+  uint32_t labelGeneration = 1u;
+
+  // Damage stuff, everything is damaged after changes that affect the whole frame
+  bool damageAll = true;
+  bool frameChanged = true;
+  std::pmr::vector<Rect> damageRects{ resource };
+  Rect damageBounds = { 0, 0, 0, 0 };
+
+  // Instrumentation stuff
+  TraceSink* traceSink = nullptr;
+  FrameStats frameStats;
+
+  explicit Data(std::pmr::memory_resource* resource) : resource(resource)
+  {
+  }
+
+  const unsigned char* getFontTexture() const;
+  size_t countGlyphs(std::string_view text) const;
+  size_t countLabelGlyphs(uint32_t slot) const;
+  size_t getVerticesPerQuad() const;
+  void runTasks(size_t numTasks, const std::function<void(size_t)>& task);
+  bool getChunkSlots(size_t chunk, uint32_t& firstSlot, uint32_t& endSlot) const;
+  void resetGlyphAtlas();
+  uint32_t getNode(WidgetHandle widget) const;
+  void applyCommands(Context& context);
+  void measureLabel(std::string_view text, int32_t& width, int32_t& height) const;
+  void invalidateNode(uint32_t node);
+  void invalidateLabels();
+  void detachNode(uint32_t node);
+  void resolveLayout();
+  void enableSpatialIndex();
+  void updateSpatialIndex();
+  WidgetHandle findWidget(int32_t x, int32_t y);
+  PointerEvent getQueuedPointer() const;
+  void processInput();
+  bool isCulling() const;
+  void setCulling(bool culling);
+  void findCandidates(const SpatialGrid& grid, const SlotAllocator& slots, std::pmr::vector<uint32_t>& candidates);
+  void updateOcclusion();
+  void clearOccludedNodes();
+  bool isCovered(const Rect& rect);
+  void addCoverage(const Rect& rect);
+  template<typename Slot>
+  bool updateVisibility(const std::pmr::vector<uint32_t>& candidates,
+                        std::pmr::vector<Slot>& slots,
+                        std::pmr::vector<uint32_t>& visibleSlots);
+  void layout();
+  void countChunk(size_t chunk);
+  void layoutChunk(size_t chunk);
+  void writeChunk(size_t chunk);
+  void emitRectangle(Chunk& chunk,
+                     size_t rectangle,
+                     int32_t x,
+                     int32_t y,
+                     int32_t w,
+                     int32_t h,
+                     float r,
+                     float g,
+                     float b);
+  void flushRectangles(Chunk& chunk);
+  void writeWindow(Chunk& chunk, uint32_t slot);
+  void writeButton(Chunk& chunk, uint32_t slot);
+  void writeLabel(Chunk& chunk, uint32_t slot);
+  void shapeLabel(ButtonSlot& slot, std::string_view text, FrameStats& stats);
+  uint32_t stackNode(uint32_t node, const Rect& bounds);
+  void addDrawCommands(uint32_t node, const Rect& clipRect);
+  void buildDrawList();
+  void updateDamage();
+  void damageWindow(uint32_t slot);
+  void damageButton(uint32_t slot);
+  Rect getButtonBounds(uint32_t slot) const;
+  void addDamage(const Rect& oldBounds, const Rect& newBounds);
+};
+
+const unsigned char* Context::Data::getFontTexture() const
+{
+  return glyphAtlas ? fontBitmap.data() : font->d->texture;
+}
+
+size_t Context::Data::countGlyphs(std::string_view text) const
+{
+  size_t count = 0u;
+  if (error != Error::Success)
+  {
+    return count;
+  }
+
+  if (glyphAtlas)
+  {
+    const char* it = text.data();
+    const char* end = it + text.size();
+    while (it != end)
+    {
+      if (decodeUtf8(it, end) >= 32u)
+      {
+        ++count;
+      }
+    }
+  }
+  else
+  {
+    for (const char& c : text)
+    {
+      if (isSupportedCharacter(c))
+      {
+        ++count;
+      }
+    }
+  }
+
+  return count;
+}
+
+size_t Context::Data::countLabelGlyphs(uint32_t slot) const
+{
+  const ButtonSlot& buttonSlot = buttonSlots[slot];
+  const std::string_view text = buttons.texts[slot];
+  if (buttonSlot.labelGeneration == labelGeneration && buttonSlot.labelText == text)
+  {
+    return buttonSlot.labelVertices.size() / getVerticesPerQuad();
+  }
+
+  return countGlyphs(text);
+}
+
+size_t Context::Data::getVerticesPerQuad() const
+{
+  return indexType == IndexType::None ? verticesPerQuad : verticesPerIndexedQuad;
+}
+
+void Context::Data::runTasks(size_t numTasks, const std::function<void(size_t)>& task)
+{
+  if (taskExecutor)
+  {
+    taskExecutor(numTasks, task);
+  }
+  else if (threadPool)
+  {
+    threadPool->run(numTasks, task);
+  }
+  else
+  {
+    for (size_t index = 0u; index < numTasks; ++index)
+    {
+      task(index);
+    }
+  }
+}
+
+// Window chunks come first, returns whether the chunk covers windows
+bool Context::Data::getChunkSlots(size_t chunk, uint32_t& firstSlot, uint32_t& endSlot) const
+{
+  const size_t numWindowChunks = (windowSlots.size() + slotsPerChunk - 1u) / slotsPerChunk;
+  const bool isWindowChunk = chunk < numWindowChunks;
+  const size_t numSlots = isWindowChunk ? windowSlots.size() : buttonSlots.size();
+
+  firstSlot = static_cast<uint32_t>((isWindowChunk ? chunk : chunk - numWindowChunks) * slotsPerChunk);
+  endSlot = static_cast<uint32_t>(std::min<size_t>(firstSlot + slotsPerChunk, numSlots));
+  return isWindowChunk;
+}
+
+void Context::Data::resetGlyphAtlas()
+{
+  if (dynamicGlyphs || distanceFieldText)
+  {
+    fontBitmap.resize(static_cast<size_t>(fontTextureSize) * fontTextureSize);
+    glyphAtlas = std::make_unique<GlyphAtlas>(font->d->info, fontPixelHeight, distanceFieldText, fontBitmap.data(),
+                                              fontTextureSize, fontTextureSize);
+    glyphAtlasGeneration = 0u;
+  }
+  else
+  {
+    glyphAtlas.reset();
+    fontBitmap.clear();
+    fontBitmap.shrink_to_fit();
+  }
+
+  fontTextureDirty = true;
+  layoutDirty = true;
+  damageAll = true;
+  ++labelGeneration;
+  invalidateLabels();
+}
+
+uint32_t Context::Data::getNode(WidgetHandle widget) const
+{
+  if (widget.type == WidgetHandle::Type::Window && windows.slots.isAlive(widget.slot, widget.generation))
+  {
+    return WidgetTree::getWindowNode(widget.slot);
+  }
+
+  if (widget.type == WidgetHandle::Type::Button && buttons.slots.isAlive(widget.slot, widget.generation))
+  {
+    return WidgetTree::getButtonNode(widget.slot);
+  }
+
+  return WidgetTree::noNode;
+}
+
+// Changes queued by other threads go through the same setters, in the order they were queued
+void Context::Data::applyCommands(Context& context)
+{
+  Command* const commands = commandQueue.take();
+  for (const Command* command = commands; command; command = command->next)
+  {
+    const WindowHandle window = { command->slot, command->generation };
+    const ButtonHandle button = { command->slot, command->generation };
+    if (command->type == Command::Type::WindowPosition)
+    {
+      context.setWindowPosition(window, command->x, command->y);
+    }
+    else if (command->type == Command::Type::WindowSize)
+    {
+      context.setWindowSize(window, command->x, command->y);
+    }
+    else if (command->type == Command::Type::WindowColor)
+    {
+      context.setWindowColor(window, command->r, command->g, command->b);
+    }
+    else if (command->type == Command::Type::ButtonText)
+    {
+      context.setButtonText(button, command->text);
+    }
+    else if (command->type == Command::Type::ButtonPosition)
+    {
+      context.setButtonPosition(button, command->x, command->y);
+    }
+    else if (command->type == Command::Type::ButtonSize)
+    {
+      context.setButtonSize(button, command->x, command->y);
+    }
+  }
+
+  commandQueue.recycle(commands);
+}
+
+// Label extents from the font metrics, with the margin of 5 pixels that writeLabel() leaves around them
+void Context::Data::measureLabel(std::string_view text, int32_t& width, int32_t& height) const
+{
+  width = 0;
+  height = 0;
+  if (error != Error::Success)
+  {
+    return;
+  }
+
+  const stbtt_fontinfo& info = font->d->info;
+  const float scale = stbtt_ScaleForPixelHeight(&info, fontPixelHeight);
+
+  float advance = 0.0f;
+  if (glyphAtlas)
+  {
+    const char* it = text.data();
+    const char* const end = it + text.size();
+    while (it != end)
+    {
+      const uint32_t codepoint = decodeUtf8(it, end);
+      if (codepoint >= 32u)
+      {
+        int codepointAdvance, leftSideBearing;
+        stbtt_GetCodepointHMetrics(&info, static_cast<int>(codepoint), &codepointAdvance, &leftSideBearing);
+        advance += codepointAdvance * scale;
+      }
+    }
+  }
+  else
+  {
+    for (const char& c : text)
+    {
+      if (isSupportedCharacter(c))
+      {
+        advance += font->d->characters[c - firstBakedCodepoint].xadvance;
+      }
+    }
+  }
+
+  int ascent, descent, lineGap;
+  stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+  width = static_cast<int32_t>(std::ceil(advance * textScale)) + 10;
+  height = static_cast<int32_t>(std::ceil((ascent - descent) * scale * textScale)) + 10;
+}
+
+void Context::Data::invalidateNode(uint32_t node)
+{
+  if (WidgetTree::isButtonNode(node))
+  {
+    buttons.invalidate(WidgetTree::getSlot(node));
+  }
+  else
+  {
+    windows.invalidate(WidgetTree::getSlot(node));
+  }
+}
+
+// Laid out buttons are measured again after changes to the glyphs or their scale
+void Context::Data::invalidateLabels()
+{
+  for (uint32_t slot = 0u; slot < buttons.slots.size(); ++slot)
+  {
+    if (buttons.slots.isAlive(slot) && widgetLayout.isLaidOut(WidgetTree::getButtonNode(slot)))
+    {
+      buttons.invalidate(slot);
+    }
+  }
+}
+
+// Takes a widget that is about to be destroyed out of the tree, its children are positioned relative to the origin
+void Context::Data::detachNode(uint32_t node)
+{
+  const uint32_t parent = tree.getParent(node);
+  if (parent != WidgetTree::noNode)
+  {
+    widgetLayout.markDirty(parent);
+  }
+
+  for (uint32_t child = tree.getFirstChild(node); child != WidgetTree::noNode; child = tree.getNextSibling(child))
+  {
+    invalidateNode(child);
+  }
+
+  tree.remove(node);
+  widgetLayout.remove(node);
+}
+
+void Context::Data::resolveLayout()
+{
+  // Labels are only measured for buttons that are laid out
+  for (const uint32_t slot : windows.unresolvedSlots)
+  {
+    widgetLayout.markDirty(WidgetTree::getWindowNode(slot));
+  }
+
+  for (const uint32_t slot : buttons.unresolvedSlots)
+  {
+    const uint32_t node = WidgetTree::getButtonNode(slot);
+    if (widgetLayout.isLaidOut(node))
+    {
+      int32_t width, height;
+      measureLabel(buttons.texts[slot], width, height);
+      widgetLayout.setContentSize(node, width, height);
+    }
+
+    widgetLayout.markDirty(node);
+  }
+
+  // Lists the children it moves as unresolved too
+  widgetLayout.update();
+
+  // Widgets outside of the tree are where their local position says, the others are resolved with their subtree
+  for (const uint32_t slot : windows.unresolvedSlots)
+  {
+    const uint32_t node = WidgetTree::getWindowNode(slot);
+    if (tree.isLinked(node))
+    {
+      tree.markMoved(node);
+    }
+    else
+    {
+      windows.x[slot] = windows.localX[slot];
+      windows.y[slot] = windows.localY[slot];
+    }
+  }
+
+  for (const uint32_t slot : buttons.unresolvedSlots)
+  {
+    const uint32_t node = WidgetTree::getButtonNode(slot);
+    if (tree.isLinked(node))
+    {
+      tree.markMoved(node);
+    }
+    else
+    {
+      buttons.x[slot] = buttons.localX[slot];
+      buttons.y[slot] = buttons.localY[slot];
+    }
+  }
+
+  windows.clearUnresolvedSlots();
+  buttons.clearUnresolvedSlots();
+
+  // Parents come first, so their absolute position is already resolved. Only widgets that actually moved are touched.
+  resolvedNodes.clear();
+  tree.resolve(resolvedNodes);
+  for (const uint32_t node : resolvedNodes)
+  {
+    int32_t x = 0;
+    int32_t y = 0;
+    const uint32_t parent = tree.getParent(node);
+    if (parent != WidgetTree::noNode)
+    {
+      x = windows.x[WidgetTree::getSlot(parent)];
+      y = windows.y[WidgetTree::getSlot(parent)];
+    }
+
+    const uint32_t slot = WidgetTree::getSlot(node);
+    WidgetStorage& storage = WidgetTree::isButtonNode(node) ? static_cast<WidgetStorage&>(buttons) : windows;
+    x += storage.localX[slot];
+    y += storage.localY[slot];
+    if (storage.x[slot] != x || storage.y[slot] != y)
+    {
+      storage.x[slot] = x;
+      storage.y[slot] = y;
+      storage.touch(slot);
+    }
+  }
+}
+
+void Context::Data::enableSpatialIndex()
+{
+  if (spatialIndex)
+  {
+    return;
+  }
+
+  spatialIndex = true;
+  for (uint32_t slot = 0u; slot < windows.slots.size(); ++slot)
+  {
+    if (windows.slots.isAlive(slot))
+    {
+      windowGrid.insert(slot, { windows.x[slot], windows.y[slot], windows.width[slot], windows.height[slot] });
+    }
+  }
+
+  for (uint32_t slot = 0u; slot < buttons.slots.size(); ++slot)
+  {
+    if (buttons.slots.isAlive(slot))
+    {
+      buttonGrid.insert(slot, { buttons.x[slot], buttons.y[slot], buttons.width[slot], buttons.height[slot] });
+    }
+  }
+}
+
+void Context::Data::updateSpatialIndex()
+{
+  resolveLayout();
+  if (spatialIndex)
+  {
+    for (const uint32_t slot : windows.unindexedSlots)
+    {
+      if (windows.slots.isAlive(slot))
+      {
+        windowGrid.insert(slot, { windows.x[slot], windows.y[slot], windows.width[slot], windows.height[slot] });
+      }
+      else
+      {
+        windowGrid.remove(slot);
+      }
+    }
+
+    for (const uint32_t slot : buttons.unindexedSlots)
+    {
+      if (buttons.slots.isAlive(slot))
+      {
+        buttonGrid.insert(slot, { buttons.x[slot], buttons.y[slot], buttons.width[slot], buttons.height[slot] });
+      }
+      else
+      {
+        buttonGrid.remove(slot);
+      }
+    }
+  }
+
+  windows.clearUnindexedSlots();
+  buttons.clearUnindexedSlots();
+}
+
+WidgetHandle Context::Data::findWidget(int32_t x, int32_t y)
+{
+  // Buttons are drawn after windows, and later slots after earlier ones
+  queryResult.clear();
+  buttonGrid.query(x, y, queryResult);
+  if (!queryResult.empty())
+  {
+    const uint32_t slot = *std::max_element(queryResult.begin(), queryResult.end());
+    return ButtonHandle{ slot, buttons.slots.getGeneration(slot) };
+  }
+
+  windowGrid.query(x, y, queryResult);
+  if (!queryResult.empty())
+  {
+    const uint32_t slot = *std::max_element(queryResult.begin(), queryResult.end());
+    return WindowHandle{ slot, windows.slots.getGeneration(slot) };
+  }
+
+  return WidgetHandle();
+}
+
+Context::Data::PointerEvent Context::Data::getQueuedPointer() const
+{
+  return pointerEvents.empty() ? pointer : pointerEvents.back();
+}
+
+void Context::Data::processInput()
+{
+  // Moves in between button changes do not matter, only the final position is hit tested for hovering
+  clickedWidgets.clear();
+  for (const PointerEvent& event : pointerEvents)
+  {
+    if (event.down != pointer.down)
+    {
+      const WidgetHandle widget = findWidget(event.x, event.y);
+      if (event.down)
+      {
+        pressedWidget = widget;
+      }
+      else
+      {
+        if (widget.type != WidgetHandle::Type::None && widget == pressedWidget)
+        {
+          clickedWidgets.push_back(widget);
+        }
+
+        pressedWidget = WidgetHandle();
+      }
+    }
+
+    pointer = event;
+  }
+
+  pointerEvents.clear();
+
+  // Widgets move underneath a resting pointer too
+  hoveredWidget = findWidget(pointer.x, pointer.y);
+}
+
+// Whether widgets are drawn only once they were found to be visible
+bool Context::Data::isCulling() const
+{
+  return hasViewport || occlusionCulling;
+}
+
+// Switches between drawing every widget and drawing the visible ones, which the next frame finds again
+void Context::Data::setCulling(bool culling)
+{
+  for (WindowSlot& slot : windowSlots)
+  {
+    slot.visible = !culling;
+  }
+
+  for (ButtonSlot& slot : buttonSlots)
+  {
+    slot.visible = !culling;
+  }
+
+  for (Chunk& chunk : chunks)
+  {
+    chunk.culled = false;
+  }
+
+  visibleWindows.clear();
+  visibleButtons.clear();
+  layoutDirty = true;
+  damageAll = true;
+  if (culling)
+  {
+    enableSpatialIndex();
+  }
+}
+
+void Context::Data::findCandidates(const SpatialGrid& grid,
+                                   const SlotAllocator& slots,
+                                   std::pmr::vector<uint32_t>& candidates)
+{
+  candidates.clear();
+  if (hasViewport)
+  {
+    grid.query(viewport, candidates);
+    return;
+  }
+
+  for (uint32_t slot = 0u; slot < slots.size(); ++slot)
+  {
+    if (slots.isAlive(slot))
+    {
+      candidates.push_back(slot);
+    }
+  }
+}
+
+void Context::Data::updateOcclusion()
+{
+  previousOccludedNodes.assign(occludedNodes.begin(), occludedNodes.end());
+  clearOccludedNodes();
+  coverageGrid.clear();
+  coverageRects.clear();
+  occlusionDirty = false;
+
+  // Buttons are drawn after windows, and later slots after earlier ones
+  std::sort(candidateButtons.begin(), candidateButtons.end(), std::greater<uint32_t>());
+  std::sort(candidateWindows.begin(), candidateWindows.end(), std::greater<uint32_t>());
+
+  for (const uint32_t slot : candidateButtons)
+  {
+    ButtonSlot& buttonSlot = buttonSlots[slot];
+    const Rect box = { buttons.x[slot], buttons.y[slot], buttons.width[slot], buttons.height[slot] };
+
+    // Labels that were not shaped for their text yet have unknown bounds, so they are tested again next frame
+    const std::string_view text = error == Error::Success ? buttons.texts[slot] : std::string_view();
+    const bool labelShaped = buttonSlot.labelGeneration == labelGeneration && buttonSlot.labelText == text;
+    if (!hasViewport && !labelShaped)
+    {
+      occlusionDirty = true;
+    }
+    else if (isCovered(getButtonBounds(slot)))
+    {
+      buttonSlot.occluded = true;
+      occludedNodes.push_back(WidgetTree::getButtonNode(slot));
+      continue;
+    }
+
+    addCoverage(box);
+  }
+
+  for (const uint32_t slot : candidateWindows)
+  {
+    const Rect box = { windows.x[slot], windows.y[slot], windows.width[slot], windows.height[slot] };
+    if (isCovered(box))
+    {
+      windowSlots[slot].occluded = true;
+      occludedNodes.push_back(WidgetTree::getWindowNode(slot));
+      continue;
+    }
+
+    addCoverage(box);
+  }
+
+  // Widgets that were hidden or revealed change their drawn bounds. Both lists are in the order of the walk.
+  const auto walkOrder = [](uint32_t a, uint32_t b) {
+    const bool buttonA = WidgetTree::isButtonNode(a);
+    return buttonA != WidgetTree::isButtonNode(b) ? buttonA : a > b;
+  };
+
+  std::set_symmetric_difference(previousOccludedNodes.begin(), previousOccludedNodes.end(), occludedNodes.begin(),
+                                occludedNodes.end(), std::back_inserter(occlusionChangedNodes), walkOrder);
+}
+
+void Context::Data::clearOccludedNodes()
+{
+  for (const uint32_t node : occludedNodes)
+  {
+    const uint32_t slot = WidgetTree::getSlot(node);
+    bool& occluded = WidgetTree::isButtonNode(node) ? buttonSlots[slot].occluded : windowSlots[slot].occluded;
+    occluded = false;
+  }
+
+  occludedNodes.clear();
+}
+
+// Returns whether a rectangle lies within the union of the boxes covered so far. Empty rectangles are never covered.
+bool Context::Data::isCovered(const Rect& rect)
+{
+  if (isEmpty(rect))
+  {
+    return false;
+  }
+
+  queryResult.clear();
+  coverageGrid.query(rect, queryResult);
+
+  // Most hidden widgets are behind a single box, which is found before splitting the rectangle
+  for (const uint32_t item : queryResult)
+  {
+    const Rect overlap = getIntersection(rect, coverageRects[item]);
+    if (overlap.width == rect.width && overlap.height == rect.height)
+    {
+      return true;
+    }
+  }
+
+  uncoveredRects.assign(1u, rect);
+  for (const uint32_t item : queryResult)
+  {
+    remainingRects.clear();
+    for (const Rect& uncovered : uncoveredRects)
+    {
+      subtractRect(uncovered, coverageRects[item], remainingRects);
+    }
+
+    uncoveredRects.swap(remainingRects);
+    if (uncoveredRects.empty())
+    {
+      return true;
+    }
+
+    if (uncoveredRects.size() > maxUncoveredRects)
+    {
+      return false;
+    }
+  }
+
+  return false;
+}
+
+void Context::Data::addCoverage(const Rect& rect)
+{
+  if (!isEmpty(rect))
+  {
+    coverageGrid.insert(static_cast<uint32_t>(coverageRects.size()), rect);
+    coverageRects.push_back(rect);
+  }
+}
+
+// Returns whether the set of visible slots changed, candidates are visible unless they are occluded
+template<typename Slot>
+bool Context::Data::updateVisibility(const std::pmr::vector<uint32_t>& candidates,
+                                     std::pmr::vector<Slot>& slots,
+                                     std::pmr::vector<uint32_t>& visibleSlots)
+{
+  queryResult.clear();
+  for (const uint32_t slot : candidates)
+  {
+    if (!slots[slot].occluded)
+    {
+      queryResult.push_back(slot);
+    }
+  }
+
+  // The sets are equal if they have the same size and everything visible now was visible before
+  bool changed = queryResult.size() != visibleSlots.size();
+  for (const uint32_t slot : queryResult)
+  {
+    changed = changed || !slots[slot].visible;
+  }
+
+  if (changed)
+  {
+    for (const uint32_t slot : visibleSlots)
+    {
+      slots[slot].visible = false;
+    }
+
+    for (const uint32_t slot : queryResult)
+    {
+      slots[slot].visible = true;
+    }
+
+    visibleSlots.swap(queryResult);
+  }
+
+  return changed;
+}
+
+void Context::Data::layout()
+{
+  TraceSink::Scope scope(traceSink, "layout");
+  const size_t verticesPerQuad = getVerticesPerQuad();
+  const size_t colorVertexCapacity = colorVertices.capacity();
+  const size_t rectangleInstanceCapacity = rectangleInstances.capacity();
+  const size_t textureVertexCapacity = textureVertices.capacity();
+  const size_t indexCapacity = indices16.capacity() + indices32.capacity();
+
+  // Count what every chunk needs, then hand out consecutive ranges in chunk order
+  runTasks(chunks.size(), [this](size_t chunk) { countChunk(chunk); });
+
+  size_t numRectangles = 0u;
+  numTextureVertices = 0u;
+  for (Chunk& chunk : chunks)
+  {
+    chunk.firstRectangle = numRectangles;
+    chunk.firstTextureVertex = numTextureVertices;
+    numRectangles += chunk.numRectangles;
+    numTextureVertices += chunk.numTextureVertices;
+  }
+
+  runTasks(chunks.size(), [this](size_t chunk) { layoutChunk(chunk); });
+
+  numColorVertices = instancedRectangles ? 0u : numRectangles * verticesPerQuad;
+  numRectangleInstances = instancedRectangles ? numRectangles : 0u;
+
+  outputOverflow = hasOutputBuffers && (numColorVertices > outputBuffers.colorVertexCapacity ||
+                                        numTextureVertices > outputBuffers.textureVertexCapacity ||
+                                        numRectangleInstances > outputBuffers.rectangleInstanceCapacity);
+  if (hasOutputBuffers && !outputOverflow)
+  {
+    colorVertices.clear();
+    textureVertices.clear();
+    rectangleInstances.clear();
+    colorOutput = outputBuffers.colorVertices;
+    textureOutput = outputBuffers.textureVertices;
+    rectangleOutput = outputBuffers.rectangleInstances;
+  }
+  else
+  {
+    colorVertices.resize(numColorVertices);
+    textureVertices.resize(numTextureVertices);
+    rectangleInstances.resize(numRectangleInstances);
+    colorOutput = colorVertices.data();
+    textureOutput = textureVertices.data();
+    rectangleOutput = rectangleInstances.data();
+  }
+
+  const size_t numQuads = std::max(numColorVertices, numTextureVertices) / verticesPerQuad;
+  if (indexType == IndexType::UInt16)
+  {
+    growQuadIndices(indices16, std::min(numQuads, maxQuadsPerUInt16Batch));
+  }
+  else if (indexType == IndexType::UInt32)
+  {
+    growQuadIndices(indices32, numQuads);
+  }
+
+  frameStats.numReallocations += countReallocation(colorVertices, colorVertexCapacity) +
+                                 countReallocation(rectangleInstances, rectangleInstanceCapacity) +
+                                 countReallocation(textureVertices, textureVertexCapacity) +
+                                 (indices16.capacity() + indices32.capacity() != indexCapacity ? 1u : 0u);
+  layoutDirty = false;
+}
+
+void Context::Data::countChunk(size_t chunk)
+{
+  Chunk& output = chunks[chunk];
+  output.numRectangles = 0u;
+  output.numTextureVertices = 0u;
+  if (output.culled)
+  {
+    return;
+  }
+
+  uint32_t firstSlot, endSlot;
+  if (getChunkSlots(chunk, firstSlot, endSlot))
+  {
+    for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+    {
+      output.numRectangles += windows.slots.isAlive(slot) && windowSlots[slot].visible ? 1u : 0u;
+    }
+
+    return;
+  }
+
+  const size_t verticesPerQuad = getVerticesPerQuad();
+  for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+  {
+    ButtonSlot& buttonSlot = buttonSlots[slot];
+    if (!buttons.slots.isAlive(slot) || !buttonSlot.visible)
+    {
+      buttonSlot.numTextureVertices = 0u;
+      continue;
+    }
+
+    size_t numGlyphs = countLabelGlyphs(slot);
+    if (retainedMode)
+    {
+      numGlyphs = (numGlyphs + labelGlyphGranularity) / labelGlyphGranularity * labelGlyphGranularity;
+    }
+
+    buttonSlot.numTextureVertices = numGlyphs * verticesPerQuad;
+    output.numTextureVertices += buttonSlot.numTextureVertices;
+    ++output.numRectangles;
+  }
+}
+
+void Context::Data::layoutChunk(size_t chunk)
+{
+  Chunk& output = chunks[chunk];
+  if (output.culled && !output.hasRanges)
+  {
+    return;
+  }
+
+  output.hasRanges = output.numRectangles > 0u;
+  size_t rectangle = output.firstRectangle;
+  size_t textureVertex = output.firstTextureVertex;
+
+  // Destroyed and culled widgets give up their ranges
+  uint32_t firstSlot, endSlot;
+  if (getChunkSlots(chunk, firstSlot, endSlot))
+  {
+    for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+    {
+      WindowSlot& windowSlot = windowSlots[slot];
+      windowSlot.rectangle = windows.slots.isAlive(slot) && windowSlot.visible ? rectangle++ : noRectangle;
+    }
+
+    return;
+  }
+
+  for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+  {
+    ButtonSlot& buttonSlot = buttonSlots[slot];
+    if (buttons.slots.isAlive(slot) && buttonSlot.visible)
+    {
+      buttonSlot.rectangle = rectangle++;
+      buttonSlot.firstTextureVertex = textureVertex;
+      textureVertex += buttonSlot.numTextureVertices;
+    }
+    else
+    {
+      buttonSlot.rectangle = noRectangle;
+      buttonSlot.firstTextureVertex = 0u;
+    }
+  }
+}
+
+void Context::Data::writeChunk(size_t chunk)
+{
+  Chunk& output = chunks[chunk];
+  output.colorVertexRanges.clear();
+  output.textureVertexRanges.clear();
+  output.rectangleInstanceRanges.clear();
+  output.stats = FrameStats();
+  if (!output.hasRanges)
+  {
+    return;
+  }
+
+  const size_t rectangleBatchCapacity = output.rectangleBatch.capacity();
+  const size_t colorVertexRangeCapacity = output.colorVertexRanges.capacity();
+  const size_t textureVertexRangeCapacity = output.textureVertexRanges.capacity();
+  const size_t rectangleInstanceRangeCapacity = output.rectangleInstanceRanges.capacity();
+
+  uint32_t firstSlot, endSlot;
+  if (getChunkSlots(chunk, firstSlot, endSlot))
+  {
+    TraceSink::Scope scope(traceSink, "write windows");
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+    {
+      const WindowSlot& windowSlot = windowSlots[slot];
+      if (windowSlot.rectangle == noRectangle)
+      {
+        continue;
+      }
+
+      ++output.stats.numWidgetsVisited;
+      if (rewriteAll || windows.revisions[slot] != windowSlot.revision)
+      {
+        writeWindow(output, slot);
+      }
+      else
+      {
+        ++output.stats.numWidgetsSkipped;
+      }
+    }
+
+    flushRectangles(output);
+    output.stats.windowTime = getMilliseconds(start);
+  }
+  else
+  {
+    // Labels go first since writing the box marks the button as written
+    {
+      TraceSink::Scope scope(traceSink, "write labels");
+      const auto start = std::chrono::steady_clock::now();
+      for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+      {
+        const ButtonSlot& buttonSlot = buttonSlots[slot];
+        if (buttonSlot.rectangle != noRectangle && (rewriteAll || buttons.revisions[slot] != buttonSlot.revision))
+        {
+          writeLabel(output, slot);
+        }
+      }
+
+      output.stats.textTime = getMilliseconds(start);
+    }
+
+    TraceSink::Scope scope(traceSink, "write buttons");
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t slot = firstSlot; slot < endSlot; ++slot)
+    {
+      const ButtonSlot& buttonSlot = buttonSlots[slot];
+      if (buttonSlot.rectangle == noRectangle)
+      {
+        continue;
+      }
+
+      ++output.stats.numWidgetsVisited;
+      if (rewriteAll || buttons.revisions[slot] != buttonSlot.revision)
+      {
+        writeButton(output, slot);
+      }
+      else
+      {
+        ++output.stats.numWidgetsSkipped;
+      }
+    }
+
+    flushRectangles(output);
+    output.stats.buttonTime = getMilliseconds(start);
+  }
+
+  output.stats.numReallocations += countReallocation(output.rectangleBatch, rectangleBatchCapacity) +
+                                   countReallocation(output.colorVertexRanges, colorVertexRangeCapacity) +
+                                   countReallocation(output.textureVertexRanges, textureVertexRangeCapacity) +
+                                   countReallocation(output.rectangleInstanceRanges, rectangleInstanceRangeCapacity);
+}
+
+void Context::Data::emitRectangle(Chunk& chunk,
+                                  size_t rectangle,
+                                  int32_t x,
+                                  int32_t y,
+                                  int32_t w,
+                                  int32_t h,
+                                  float r,
+                                  float g,
+                                  float b)
+{
+  if (instancedRectangles)
+  {
+    rectangleOutput[rectangle] = {
+      static_cast<float>(x), static_cast<float>(y), static_cast<float>(w), static_cast<float>(h), r, g, b
+    };
+    addRange(chunk.rectangleInstanceRanges, rectangle * sizeof(RectangleInstance), sizeof(RectangleInstance));
+    return;
+  }
+
+  std::pmr::vector<RectangleInput>& batch = chunk.rectangleBatch;
+  if (!batch.empty() && chunk.firstBatchedRectangle + batch.size() != rectangle)
+  {
+    flushRectangles(chunk);
+  }
+
+  if (batch.empty())
+  {
+    chunk.firstBatchedRectangle = rectangle;
+  }
+
+  batch.push_back({ x, y, w, h, r, g, b, 0.0f });
+}
+
+void Context::Data::flushRectangles(Chunk& chunk)
+{
+  std::pmr::vector<RectangleInput>& batch = chunk.rectangleBatch;
+  if (batch.empty())
+  {
+    return;
+  }
+
+  const size_t verticesPerQuad = getVerticesPerQuad();
+  const size_t first = chunk.firstBatchedRectangle * verticesPerQuad;
+  if (indexType == IndexType::None)
+  {
+    kernels->expandRectangles(batch.data(), batch.size(), colorOutput + first);
+  }
+  else
+  {
+    kernels->expandIndexedRectangles(batch.data(), batch.size(), colorOutput + first);
+  }
+
+  addRange(chunk.colorVertexRanges, first * sizeof(ColorVertex), batch.size() * verticesPerQuad * sizeof(ColorVertex));
+  batch.clear();
+}
+
+void Context::Data::writeWindow(Chunk& chunk, uint32_t slot)
+{
+  WindowSlot& windowSlot = windowSlots[slot];
+  windowSlot.revision = windows.revisions[slot];
+
+  // Destroyed windows keep their range as a degenerate rectangle until the next layout
+  if (!windows.slots.isAlive(slot))
+  {
+    emitRectangle(chunk, windowSlot.rectangle, 0, 0, 0, 0, 0.0f, 0.0f, 0.0f);
+    return;
+  }
+
+  const int32_t x = windows.x[slot];
+  const int32_t y = windows.y[slot];
+  const int32_t w = windows.width[slot];
+  const int32_t h = windows.height[slot];
+
+  const float r = windows.colorR[slot];
+  const float g = windows.colorG[slot];
+  const float b = windows.colorB[slot];
+
+  emitRectangle(chunk, windowSlot.rectangle, x, y, w, h, r, g, b);
+}
+
+void Context::Data::writeButton(Chunk& chunk, uint32_t slot)
+{
+  ButtonSlot& buttonSlot = buttonSlots[slot];
+  buttonSlot.revision = buttons.revisions[slot];
+
+  // Draw the box
+  if (buttons.slots.isAlive(slot))
+  {
+    const int32_t x = buttons.x[slot];
+    const int32_t y = buttons.y[slot];
+    const int32_t w = buttons.width[slot];
+    const int32_t h = buttons.height[slot];
+
+    const float r = 1.0f;
+    const float g = 1.0f;
+    const float b = 1.0f;
+
+    emitRectangle(chunk, buttonSlot.rectangle, x, y, w, h, r, g, b);
+  }
+  else
+  {
+    emitRectangle(chunk, buttonSlot.rectangle, 0, 0, 0, 0, 0.0f, 0.0f, 0.0f);
+  }
+}
+
+void Context::Data::writeLabel(Chunk& chunk, uint32_t slot)
+{
+  ButtonSlot& buttonSlot = buttonSlots[slot];
+
+  // Labels stay empty without a font
+  const std::string_view text = error == Error::Success ? buttons.texts[slot] : std::string_view();
+  if (buttonSlot.labelGeneration != labelGeneration || buttonSlot.labelText != text)
+  {
+    shapeLabel(buttonSlot, text, chunk.stats);
+  }
+
+  chunk.stats.numGlyphs += buttonSlot.labelVertices.size() / getVerticesPerQuad();
+  chunk.stats.numGlyphsDropped += buttonSlot.numDroppedGlyphs;
+
+  // Label origins are whole pixels, so translating the cached quads matches shaping them in place
+  const float x = buttons.x[slot] + 5.0f;
+  const float y = buttons.y[slot] + buttons.height[slot] - 5.0f;
+
+  TextureVertex* vertex = textureOutput + buttonSlot.firstTextureVertex;
+  TextureVertex* const end = vertex + buttonSlot.numTextureVertices;
+  kernels->translateTextureVertices(buttonSlot.labelVertices.data(), buttonSlot.labelVertices.size(), x, y, vertex);
+  if (hasViewport)
+  {
+    const Rect box = { buttons.x[slot], buttons.y[slot], buttons.width[slot], buttons.height[slot] };
+    clipQuads(vertex, buttonSlot.labelVertices.size(), indexType != IndexType::None, box);
+  }
+
+  vertex += buttonSlot.labelVertices.size();
+
+  // Collapse the spare capacity into degenerate triangles
+  while (vertex != end)
+  {
+    *vertex++ = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+  }
+
+  addRange(chunk.textureVertexRanges, buttonSlot.firstTextureVertex * sizeof(TextureVertex),
+           buttonSlot.numTextureVertices * sizeof(TextureVertex));
+}
+
+void Context::Data::shapeLabel(ButtonSlot& slot, std::string_view text, FrameStats& stats)
+{
+  const bool indexed = indexType != IndexType::None;
+  const size_t labelVertexCapacity = slot.labelVertices.capacity();
+
+  slot.labelText = text;
+  slot.labelGeneration = labelGeneration;
+  slot.labelVertices.resize(countGlyphs(text) * getVerticesPerQuad());
+  slot.numDroppedGlyphs = 0u;
+
+  float x = 0.0f;
+  float y = 0.0f;
+
+  TextureVertex* vertex = slot.labelVertices.data();
+  const char* it = text.data();
+  const char* const textEnd = it + text.size();
+  while (it != textEnd)
+  {
+    const stbtt_bakedchar* character;
+    if (glyphAtlas)
+    {
+      const uint32_t codepoint = decodeUtf8(it, textEnd);
+      if (codepoint < 32u)
+      {
+        ++slot.numDroppedGlyphs;
+        continue;
+      }
+
+      character = glyphAtlas->findGlyph(codepoint);
+      if (!character)
+      {
+        ++slot.numDroppedGlyphs;
+        continue;
+      }
+    }
+    else
+    {
+      const char c = *it++;
+      if (!isSupportedCharacter(c))
+      {
+        ++slot.numDroppedGlyphs;
+        continue;
+      }
+
+      character = &font->d->characters[c - firstBakedCodepoint];
+    }
+
+    stbtt_aligned_quad quad;
+    stbtt_GetBakedQuad(character, fontTextureSize, fontTextureSize, 0, &x, &y, &quad, 1);
+
+    // Glyphs are baked at one size and scaled around the label origin
+    const float x0 = quad.x0 * textScale;
+    const float y0 = quad.y0 * textScale;
+    const float x1 = quad.x1 * textScale;
+    const float y1 = quad.y1 * textScale;
+
+    // clang-format off
+    vertex = writeQuad<TextureVertex>(vertex, indexed,
+                                      { x0, y0, quad.s0, quad.t0, textScale },
+                                      { x1, y0, quad.s1, quad.t0, textScale },
+                                      { x0, y1, quad.s0, quad.t1, textScale },
+                                      { x1, y1, quad.s1, quad.t1, textScale });
+    // clang-format on
+  }
+
+  // Glyphs that did not fit into the atlas are dropped
+  slot.labelVertices.resize(static_cast<size_t>(vertex - slot.labelVertices.data()));
+
+  // Scaled quads can end within pixels, the bounds cover all of those
+  slot.labelBounds = { 0, 0, 0, 0 };
+  const size_t quadSize = indexed ? verticesPerIndexedQuad : verticesPerQuad;
+  for (size_t first = 0u; first < slot.labelVertices.size(); first += quadSize)
+  {
+    const TextureVertex& topLeft = slot.labelVertices[first];
+    const TextureVertex& bottomRight = slot.labelVertices[first + quadSize - 1u];
+    const int32_t left = static_cast<int32_t>(std::floor(topLeft.getX()));
+    const int32_t top = static_cast<int32_t>(std::floor(topLeft.getY()));
+    const int32_t right = static_cast<int32_t>(std::ceil(bottomRight.getX()));
+    const int32_t bottom = static_cast<int32_t>(std::ceil(bottomRight.getY()));
+    slot.labelBounds = getUnion(slot.labelBounds, { left, top, right - left, bottom - top });
+  }
+
+  stats.numReallocations += countReallocation(slot.labelVertices, labelVertexCapacity);
+}
+
+// Returns the layer of a node above every node stacked so far that it overlaps
+uint32_t Context::Data::stackNode(uint32_t node, const Rect& bounds)
+{
+  queryResult.clear();
+  layerGrid.query(bounds, queryResult);
+
+  uint32_t layer = 0u;
+  for (const uint32_t item : queryResult)
+  {
+    layer = std::max(layer, nodeLayers[item] + 1u);
+  }
+
+  layerGrid.insert(node, bounds);
+  nodeLayers[node] = layer;
+  return layer;
+}
+
+// Labels share the layer of their box, whose pipeline sorts first
+void Context::Data::addDrawCommands(uint32_t node, const Rect& clipRect)
+{
+  const DrawCommand::Pipeline boxPipeline =
+    instancedRectangles ? DrawCommand::Pipeline::Rectangle : DrawCommand::Pipeline::Color;
+  const size_t boxCount = instancedRectangles ? 1u : getVerticesPerQuad();
+  const uint32_t slot = WidgetTree::getSlot(node);
+  if (!WidgetTree::isButtonNode(node))
+  {
+    const WindowSlot& windowSlot = windowSlots[slot];
+    if (windowSlot.rectangle != noRectangle)
+    {
+      const uint32_t layer = stackNode(node, windowSlot.drawnBounds);
+      unsortedDrawCommands.push_back({ boxPipeline, windowSlot.rectangle * boxCount, boxCount, 0u, clipRect, layer });
+    }
+
+    return;
+  }
+
+  const ButtonSlot& buttonSlot = buttonSlots[slot];
+  if (buttonSlot.rectangle == noRectangle)
+  {
+    return;
+  }
+
+  const uint32_t layer = stackNode(node, buttonSlot.drawnBounds);
+  unsortedDrawCommands.push_back({ boxPipeline, buttonSlot.rectangle * boxCount, boxCount, 0u, clipRect, layer });
+  if (buttonSlot.numTextureVertices > 0u)
+  {
+    unsortedDrawCommands.push_back({ DrawCommand::Pipeline::Text, buttonSlot.firstTextureVertex,
+                                     buttonSlot.numTextureVertices, 0u, clipRect, layer });
+  }
+}
+
+void Context::Data::buildDrawList()
+{
+  TraceSink::Scope scope(traceSink, "draw list");
+  const size_t unsortedDrawCommandCapacity = unsortedDrawCommands.capacity();
+  const size_t drawCommandCapacity = drawCommands.capacity();
+
+  layerGrid.clear();
+  nodeLayers.resize(std::max(windowSlots.size(), buttonSlots.size()) * 2u);
+  unsortedDrawCommands.clear();
+
+  // Every window is stacked together with its descendants before the next one, so that a later window covers the
+  // children of an earlier one. Buttons without a parent come after all windows.
+  const Rect clipRect = hasViewport ? viewport : Rect{ 0, 0, 0, 0 };
+  for (uint32_t slot = 0u; slot < windowSlots.size(); ++slot)
+  {
+    const uint32_t root = WidgetTree::getWindowNode(slot);
+    if (!windows.slots.isAlive(slot) || tree.getParent(root) != WidgetTree::noNode)
+    {
+      continue;
+    }
+
+    // Depth first through the subtree, parents before their children
+    uint32_t node = root;
+    while (node != WidgetTree::noNode)
+    {
+      addDrawCommands(node, clipRect);
+      uint32_t next = tree.getFirstChild(node);
+      while (next == WidgetTree::noNode && node != root)
+      {
+        next = tree.getNextSibling(node);
+        if (next == WidgetTree::noNode)
+        {
+          node = tree.getParent(node);
+        }
+      }
+
+      node = next;
+    }
+  }
+
+  for (uint32_t slot = 0u; slot < buttonSlots.size(); ++slot)
+  {
+    const uint32_t node = WidgetTree::getButtonNode(slot);
+    if (buttons.slots.isAlive(slot) && tree.getParent(node) == WidgetTree::noNode)
+    {
+      addDrawCommands(node, clipRect);
+    }
+  }
+
+  // Sorted by index last, which keeps the draw order among equal keys
+  drawOrder.resize(unsortedDrawCommands.size());
+  for (uint32_t index = 0u; index < drawOrder.size(); ++index)
+  {
+    drawOrder[index] = index;
+  }
+
+  std::sort(drawOrder.begin(), drawOrder.end(), [this](uint32_t a, uint32_t b) {
+    const DrawCommand& commandA = unsortedDrawCommands[a];
+    const DrawCommand& commandB = unsortedDrawCommands[b];
+    if (commandA.layer != commandB.layer)
+    {
+      return commandA.layer < commandB.layer;
+    }
+
+    if (commandA.pipeline != commandB.pipeline)
+    {
+      return commandA.pipeline < commandB.pipeline;
+    }
+
+    if (commandA.texturePage != commandB.texturePage)
+    {
+      return commandA.texturePage < commandB.texturePage;
+    }
+
+    return a < b;
+  });
+
+  // Consecutive commands that continue each other are drawn at once, even across layers
+  drawCommands.clear();
+  for (const uint32_t index : drawOrder)
+  {
+    const DrawCommand& command = unsortedDrawCommands[index];
+    if (!drawCommands.empty())
+    {
+      DrawCommand& last = drawCommands.back();
+      if (last.pipeline == command.pipeline && last.texturePage == command.texturePage &&
+          last.first + last.count == command.first && last.clipRect.x == command.clipRect.x &&
+          last.clipRect.y == command.clipRect.y && last.clipRect.width == command.clipRect.width &&
+          last.clipRect.height == command.clipRect.height)
+      {
+        last.count += command.count;
+        continue;
+      }
+    }
+
+    drawCommands.push_back(command);
+  }
+
+  drawListDirty = false;
+  frameStats.numReallocations += countReallocation(unsortedDrawCommands, unsortedDrawCommandCapacity) +
+                                 countReallocation(drawCommands, drawCommandCapacity);
+}
+
+void Context::Data::updateDamage()
+{
+  damageRects.clear();
+  damageBounds = { 0, 0, 0, 0 };
+
+  if (damageAll)
+  {
+    for (uint32_t slot = 0u; slot < windowSlots.size(); ++slot)
+    {
+      damageWindow(slot);
+    }
+
+    for (uint32_t slot = 0u; slot < buttonSlots.size(); ++slot)
+    {
+      damageButton(slot);
+    }
+
+    // What was outside of an old viewport may be visible now
+    damageBounds = hasViewport ? viewport : damageBounds;
+    damageRects.assign(1u, damageBounds);
+    damageAll = false;
+    occlusionChangedNodes.clear();
+    return;
+  }
+
+  for (const uint32_t slot : windows.changedSlots)
+  {
+    damageWindow(slot);
+  }
+
+  for (const uint32_t slot : buttons.changedSlots)
+  {
+    damageButton(slot);
+  }
+
+  // Widgets that were hidden or revealed without changing themselves, whose area the widgets in front of them damaged
+  for (const uint32_t node : occlusionChangedNodes)
+  {
+    const uint32_t slot = WidgetTree::getSlot(node);
+    if (WidgetTree::isButtonNode(node) && !buttons.changed[slot])
+    {
+      damageButton(slot);
+    }
+    else if (!WidgetTree::isButtonNode(node) && !windows.changed[slot])
+    {
+      damageWindow(slot);
+    }
+  }
+
+  occlusionChangedNodes.clear();
+
+  if (damageRects.size() > maxDamageRects)
+  {
+    damageRects.assign(1u, damageBounds);
+  }
+}
+
+void Context::Data::damageWindow(uint32_t slot)
+{
+  WindowSlot& windowSlot = windowSlots[slot];
+
+  Rect bounds = { 0, 0, 0, 0 };
+  if (windows.slots.isAlive(slot) && windowSlot.visible)
+  {
+    bounds = { windows.x[slot], windows.y[slot], windows.width[slot], windows.height[slot] };
+  }
+
+  addDamage(windowSlot.drawnBounds, bounds);
+  windowSlot.drawnBounds = bounds;
+}
+
+void Context::Data::damageButton(uint32_t slot)
+{
+  ButtonSlot& buttonSlot = buttonSlots[slot];
+
+  Rect bounds = { 0, 0, 0, 0 };
+  if (buttons.slots.isAlive(slot) && buttonSlot.visible)
+  {
+    bounds = getButtonBounds(slot);
+  }
+
+  addDamage(buttonSlot.drawnBounds, bounds);
+  buttonSlot.drawnBounds = bounds;
+}
+
+// Returns the box of a button and its shaped label
+Rect Context::Data::getButtonBounds(uint32_t slot) const
+{
+  const Rect box = { buttons.x[slot], buttons.y[slot], buttons.width[slot], buttons.height[slot] };
+
+  // Labels start at the same origin as in writeLabel() and are only clipped with a viewport
+  if (hasViewport)
+  {
+    return box;
+  }
+
+  Rect label = buttonSlots[slot].labelBounds;
+  label.x += buttons.x[slot] + 5;
+  label.y += buttons.y[slot] + buttons.height[slot] - 5;
+  return getUnion(box, label);
+}
+
+void Context::Data::addDamage(const Rect& oldBounds, const Rect& newBounds)
+{
+  Rect damage = getUnion(oldBounds, newBounds);
+  if (hasViewport)
+  {
+    damage = getIntersection(damage, viewport);
+  }
+
+  if (!isEmpty(damage))
+  {
+    damageRects.push_back(damage);
+    damageBounds = getUnion(damageBounds, damage);
+  }
+}
+
+WidgetHandle::WidgetHandle(WindowHandle window) : type(Type::Window), slot(window.slot), generation(window.generation)
+{
+}
+
+WidgetHandle::WidgetHandle(ButtonHandle button) : type(Type::Button), slot(button.slot), generation(button.generation)
+{
+}
+
+bool operator==(const WidgetHandle& a, const WidgetHandle& b)
+{
+  return a.type == b.type && a.slot == b.slot && a.generation == b.generation;
+}
+
+bool operator!=(const WidgetHandle& a, const WidgetHandle& b)
+{
+  return !(a == b);
+}
+
+Context::Context() : Context(defaultFontPath)
+{
+}
+
+Context::Context(const std::string& fontPath, const std::string& fontCacheDirectory)
+: Context(std::make_shared<const Font>(fontPath, fontCacheDirectory))
+{
+}
+
+Context::Context(const unsigned char* fontData, size_t fontDataSize, const std::string& fontCacheDirectory)
+: Context(std::make_shared<const Font>(fontData, fontDataSize, fontCacheDirectory))
+{
+}
+
+Context::Context(std::shared_ptr<const Font> font, std::pmr::memory_resource* resource) : d(new Data(resource))
+{
+  d->font = std::move(font);
+  d->error = d->font->getError();
+
+  d->instructionSet = getBestInstructionSet();
+  d->kernels = &getKernels(d->instructionSet);
+}
+
+Context::~Context() = default;
+
+Context::Error Context::getError() const
+{
+  return d->error;
+}
+
+void Context::addWindow(const Window& window)
+{
+  d->windows.add(window);
+}
+
+void Context::addButton(const Button& button)
+{
+  d->buttons.add(button);
+}
+
+void Context::removeWindow(const Window& window)
+{
+  const auto it = d->windows.sourceSlots.find(&window);
+  if (it != d->windows.sourceSlots.end())
+  {
+    d->detachNode(WidgetTree::getWindowNode(it->second));
+  }
+
+  d->windows.remove(window);
+}
+
+void Context::removeButton(const Button& button)
+{
+  const auto it = d->buttons.sourceSlots.find(&button);
+  if (it != d->buttons.sourceSlots.end())
+  {
+    d->detachNode(WidgetTree::getButtonNode(it->second));
+  }
+
+  d->buttons.remove(button);
+}
+
+WindowHandle Context::createWindow(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+  const uint32_t slot = d->windows.create(x, y, width, height);
+  return { slot, d->windows.slots.getGeneration(slot) };
+}
+
+void Context::destroyWindow(WindowHandle window)
+{
+  if (isValid(window))
+  {
+    d->detachNode(WidgetTree::getWindowNode(window.slot));
+    d->windows.destroy(window.slot);
+  }
+}
+
+bool Context::isValid(WindowHandle window) const
+{
+  return d->windows.slots.isAlive(window.slot, window.generation);
+}
+
+void Context::setWindowPosition(WindowHandle window, int32_t x, int32_t y)
+{
+  if (isValid(window))
+  {
+    d->windows.localX[window.slot] = x;
+    d->windows.localY[window.slot] = y;
+    d->windows.invalidate(window.slot);
+  }
+}
+
+void Context::setWindowSize(WindowHandle window, int32_t width, int32_t height)
+{
+  if (isValid(window))
+  {
+    d->windows.preferredWidth[window.slot] = width;
+    d->windows.preferredHeight[window.slot] = height;
+    d->windows.invalidate(window.slot);
+  }
+}
+
+void Context::setWindowColor(WindowHandle window, float r, float g, float b)
+{
+  if (isValid(window))
+  {
+    d->windows.colorR[window.slot] = r;
+    d->windows.colorG[window.slot] = g;
+    d->windows.colorB[window.slot] = b;
+    d->windows.touch(window.slot);
+  }
+}
+
+ButtonHandle Context::createButton(std::string_view text, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+  const uint32_t slot = d->buttons.create(text, x, y, width, height);
+  return { slot, d->buttons.slots.getGeneration(slot) };
+}
+
+void Context::destroyButton(ButtonHandle button)
+{
+  if (isValid(button))
+  {
+    d->detachNode(WidgetTree::getButtonNode(button.slot));
+    d->buttons.destroy(button.slot);
+  }
+}
+
+bool Context::isValid(ButtonHandle button) const
+{
+  return d->buttons.slots.isAlive(button.slot, button.generation);
+}
+
+void Context::setButtonText(ButtonHandle button, std::string_view text)
+{
+  if (isValid(button))
+  {
+    d->buttons.texts[button.slot] = text;
+    d->buttons.invalidate(button.slot);
+  }
+}
+
+void Context::setButtonPosition(ButtonHandle button, int32_t x, int32_t y)
+{
+  if (isValid(button))
+  {
+    d->buttons.localX[button.slot] = x;
+    d->buttons.localY[button.slot] = y;
+    d->buttons.invalidate(button.slot);
+  }
+}
+
+void Context::setButtonSize(ButtonHandle button, int32_t width, int32_t height)
+{
+  if (isValid(button))
+  {
+    d->buttons.preferredWidth[button.slot] = width;
+    d->buttons.preferredHeight[button.slot] = height;
+    d->buttons.invalidate(button.slot);
+  }
+}
+
+void Context::queueWindowPosition(WindowHandle window, int32_t x, int32_t y)
+{
+  Command* const command = d->commandQueue.allocate(Command::Type::WindowPosition, window.slot, window.generation);
+  command->x = x;
+  command->y = y;
+  d->commandQueue.push(command);
+}
+
+void Context::queueWindowSize(WindowHandle window, int32_t width, int32_t height)
+{
+  Command* const command = d->commandQueue.allocate(Command::Type::WindowSize, window.slot, window.generation);
+  command->x = width;
+  command->y = height;
+  d->commandQueue.push(command);
+}
+
+void Context::queueWindowColor(WindowHandle window, float r, float g, float b)
+{
+  Command* const command = d->commandQueue.allocate(Command::Type::WindowColor, window.slot, window.generation);
+  command->r = r;
+  command->g = g;
+  command->b = b;
+  d->commandQueue.push(command);
+}
+
+void Context::queueButtonText(ButtonHandle button, std::string_view text)
+{
+  Command* const command = d->commandQueue.allocate(Command::Type::ButtonText, button.slot, button.generation);
+  command->text.assign(text);
+  d->commandQueue.push(command);
+}
+
+void Context::queueButtonPosition(ButtonHandle button, int32_t x, int32_t y)
+{
+  Command* const command = d->commandQueue.allocate(Command::Type::ButtonPosition, button.slot, button.generation);
+  command->x = x;
+  command->y = y;
+  d->commandQueue.push(command);
+}
+
+void Context::queueButtonSize(ButtonHandle button, int32_t width, int32_t height)
+{
+  Command* const command = d->commandQueue.allocate(Command::Type::ButtonSize, button.slot, button.generation);
+  command->x = width;
+  command->y = height;
+  d->commandQueue.push(command);
+}
+
+bool Context::setParent(WidgetHandle widget, WidgetHandle parent)
+{
+  const uint32_t node = d->getNode(widget);
+  const uint32_t parentNode = parent.type == WidgetHandle::Type::Window ? d->getNode(parent) : WidgetTree::noNode;
+  const uint32_t oldParent = node != WidgetTree::noNode ? d->tree.getParent(node) : WidgetTree::noNode;
+  if (node == WidgetTree::noNode || parentNode == WidgetTree::noNode || !d->tree.setParent(node, parentNode))
+  {
+    return false;
+  }
+
+  if (oldParent != WidgetTree::noNode)
+  {
+    d->widgetLayout.markDirty(oldParent);
+  }
+
+  d->invalidateNode(node);
+  return true;
+}
+
+void Context::clearParent(WidgetHandle widget)
+{
+  const uint32_t node = d->getNode(widget);
+  if (node != WidgetTree::noNode && d->tree.getParent(node) != WidgetTree::noNode)
+  {
+    d->widgetLayout.markDirty(d->tree.getParent(node));
+    d->tree.setParent(node, WidgetTree::noNode);
+    d->invalidateNode(node);
+  }
+}
+
+WidgetHandle Context::getParent(WidgetHandle widget) const
+{
+  const uint32_t node = d->getNode(widget);
+  const uint32_t parent = node != WidgetTree::noNode ? d->tree.getParent(node) : WidgetTree::noNode;
+  if (parent == WidgetTree::noNode)
+  {
+    return WidgetHandle();
+  }
+
+  const uint32_t slot = WidgetTree::getSlot(parent);
+  return WindowHandle{ slot, d->windows.slots.getGeneration(slot) };
+}
+
+void Context::setWindowLayout(WindowHandle window, LayoutDirection direction, int32_t padding, int32_t spacing)
+{
+  if (!isValid(window))
+  {
+    return;
+  }
+
+  // Children are measured once they are laid out and get their set size back once they are not
+  const uint32_t node = WidgetTree::getWindowNode(window.slot);
+  if (direction != d->widgetLayout.getDirection(node))
+  {
+    for (uint32_t child = d->tree.getFirstChild(node); child != WidgetTree::noNode;
+         child = d->tree.getNextSibling(child))
+    {
+      d->invalidateNode(child);
+    }
+  }
+
+  d->widgetLayout.setContainer(node, direction, padding, spacing);
+  d->windows.invalidate(window.slot);
+}
+
+void Context::setWidgetSizeLimits(WidgetHandle widget,
+                                  int32_t minWidth,
+                                  int32_t minHeight,
+                                  int32_t maxWidth,
+                                  int32_t maxHeight)
+{
+  const uint32_t node = d->getNode(widget);
+  if (node != WidgetTree::noNode)
+  {
+    d->widgetLayout.setSizeLimits(node, minWidth, minHeight, maxWidth, maxHeight);
+    d->invalidateNode(node);
+  }
+}
+
+void Context::setWidgetFill(WidgetHandle widget, bool fill)
+{
+  const uint32_t node = d->getNode(widget);
+  if (node != WidgetTree::noNode)
+  {
+    d->widgetLayout.setFill(node, fill);
+    d->invalidateNode(node);
+  }
+}
+
+Rect Context::getWidgetBounds(WidgetHandle widget)
+{
+  const uint32_t node = d->getNode(widget);
+  if (node == WidgetTree::noNode)
+  {
+    return { 0, 0, 0, 0 };
+  }
+
+  d->updateSpatialIndex();
+  const uint32_t slot = WidgetTree::getSlot(node);
+  const WidgetStorage& storage =
+    WidgetTree::isButtonNode(node) ? static_cast<const WidgetStorage&>(d->buttons) : d->windows;
+  return { storage.x[slot], storage.y[slot], storage.width[slot], storage.height[slot] };
+}
+
+bool Context::getRetainedMode() const
+{
+  return d->retainedMode;
+}
+
+void Context::setRetainedMode(bool enabled)
+{
+  d->retainedMode = enabled;
+  d->layoutDirty = true;
+}
+
+Context::IndexType Context::getIndexType() const
+{
+  return d->indexType;
+}
+
+void Context::setIndexType(IndexType type)
+{
+  d->indexType = type;
+  d->layoutDirty = true;
+  ++d->labelGeneration;
+}
+
+bool Context::getInstancedRectangles() const
+{
+  return d->instancedRectangles;
+}
+
+void Context::setInstancedRectangles(bool enabled)
+{
+  d->instancedRectangles = enabled;
+  d->layoutDirty = true;
+}
+
+bool Context::getDrawList() const
+{
+  return d->drawList;
+}
+
+void Context::setDrawList(bool enabled)
+{
+  d->drawList = enabled;
+  d->drawListDirty = enabled;
+  d->drawCommands.clear();
+}
+
+bool Context::getOcclusionCulling() const
+{
+  return d->occlusionCulling;
+}
+
+void Context::setOcclusionCulling(bool enabled)
+{
+  if (d->occlusionCulling == enabled)
+  {
+    return;
+  }
+
+  d->clearOccludedNodes();
+  d->occlusionChangedNodes.clear();
+  d->occlusionCulling = enabled;
+  d->occlusionDirty = enabled;
+  d->setCulling(d->isCulling());
+}
+
+bool Context::getDynamicGlyphs() const
+{
+  return d->dynamicGlyphs;
+}
+
+void Context::setDynamicGlyphs(bool enabled)
+{
+  if (d->error != Error::Success || enabled == d->dynamicGlyphs)
+  {
+    return;
+  }
+
+  d->dynamicGlyphs = enabled;
+  d->resetGlyphAtlas();
+}
+
+bool Context::getDistanceFieldText() const
+{
+  return d->distanceFieldText;
+}
+
+void Context::setDistanceFieldText(bool enabled)
+{
+  if (d->error != Error::Success || enabled == d->distanceFieldText)
+  {
+    return;
+  }
+
+  d->distanceFieldText = enabled;
+  d->resetGlyphAtlas();
+}
+
+float Context::getTextScale() const
+{
+  return d->textScale;
+}
 
-  std::vector<const Window*> windows;
-  std::vector<const Button*> buttons;
-  std::vector<ColorVertex> colorVertices;
-  std::vector<TextureVertex> textureVertices;
+void Context::setTextScale(float scale)
+{
+  if (!(scale > 0.0f) || scale == d->textScale)
+  {
+    return;
+  }
 
-  // Font stuff
-  unsigned char fontBitmap[512 * 512];
-  stbtt_bakedchar fontCharacters[96];
-};
+  d->textScale = scale;
+  d->layoutDirty = true;
+  d->damageAll = true;
+  ++d->labelGeneration;
+  d->invalidateLabels();
+}
 
-Context::Context() : d(new Data)
+Context::InstructionSet Context::getInstructionSet() const
 {
-  d->error = Error::Success;
+  return d->instructionSet;
+}
 
-  FILE* file = nullptr;
-  if (fopen_s(&file, "C:\\Users\\janhs\\dev\\modernui-build\\src\\Debug\\Arial.ttf", "rb") != 0)
+void Context::setInstructionSet(InstructionSet set)
+{
+  if (isInstructionSetSupported(set))
   {
-    d->error = Error::FontFileMissing;
-    return;
+    d->instructionSet = set;
+    d->kernels = &getKernels(set);
+  }
+}
+
+size_t Context::getNumThreads() const
+{
+  return d->threadPool ? d->threadPool->getNumThreads() : 1u;
+}
+
+void Context::setNumThreads(size_t numThreads)
+{
+  d->taskExecutor = nullptr;
+  d->threadPool.reset();
+  if (numThreads > 1u)
+  {
+    d->threadPool = std::make_unique<ThreadPool>(numThreads);
+  }
+}
+
+void Context::setTaskExecutor(TaskExecutor executor)
+{
+  d->threadPool.reset();
+  d->taskExecutor = std::move(executor);
+}
+
+void Context::setViewport(const Rect& viewport)
+{
+  if (!d->hasViewport)
+  {
+    d->setCulling(true);
+    d->hasViewport = true;
+    d->occlusionDirty = true;
   }
 
-  constexpr size_t bufferSize = 1u << 20u;
-  unsigned char* ttfBuffer = new unsigned char[bufferSize];
-  fread(ttfBuffer, 1, bufferSize, file);
-  fclose(file);
+  const Rect& current = d->viewport;
+  const bool moved = viewport.x != current.x || viewport.y != current.y || viewport.width != current.width ||
+                     viewport.height != current.height;
+  d->damageAll = d->damageAll || moved;
+  d->occlusionDirty = d->occlusionDirty || moved;
+  d->viewport = viewport;
+}
 
-  if (!stbtt_BakeFontBitmap(ttfBuffer, 0, 32.0f, d->fontBitmap, 512, 512, 32, 96, d->fontCharacters))
+void Context::clearViewport()
+{
+  if (!d->hasViewport)
   {
-    d->error = Error::FontBakeFailed;
     return;
   }
 
-  delete[] ttfBuffer;
-  ttfBuffer = nullptr;
+  d->hasViewport = false;
+  d->setCulling(d->isCulling());
+  d->occlusionDirty = true;
 }
 
-Context::~Context() = default;
+bool Context::hasViewport() const
+{
+  return d->hasViewport;
+}
 
-Context::Error Context::getError() const
+Rect Context::getViewport() const
 {
-  return d->error;
+  return d->viewport;
 }
 
-void Context::addWindow(const Window& window)
+WidgetHandle Context::findWidget(int32_t x, int32_t y)
 {
-  d->windows.push_back(&window);
+  d->enableSpatialIndex();
+  d->updateSpatialIndex();
+  return d->findWidget(x, y);
 }
 
-void Context::addButton(const Button& button)
+size_t Context::findWidgets(const Rect& rect)
+{
+  d->enableSpatialIndex();
+  d->updateSpatialIndex();
+
+  // Sorted the way they are drawn
+  d->foundWidgets.clear();
+  d->queryResult.clear();
+  d->windowGrid.query(rect, d->queryResult);
+  std::sort(d->queryResult.begin(), d->queryResult.end());
+  for (const uint32_t slot : d->queryResult)
+  {
+    d->foundWidgets.push_back(WindowHandle{ slot, d->windows.slots.getGeneration(slot) });
+  }
+
+  d->queryResult.clear();
+  d->buttonGrid.query(rect, d->queryResult);
+  std::sort(d->queryResult.begin(), d->queryResult.end());
+  for (const uint32_t slot : d->queryResult)
+  {
+    d->foundWidgets.push_back(ButtonHandle{ slot, d->buttons.slots.getGeneration(slot) });
+  }
+
+  return d->foundWidgets.size();
+}
+
+const WidgetHandle* Context::getFoundWidgets() const
+{
+  return d->foundWidgets.data();
+}
+
+const Window* Context::getWindow(WidgetHandle widget) const
+{
+  if (widget.type != WidgetHandle::Type::Window || !d->windows.slots.isAlive(widget.slot, widget.generation))
+  {
+    return nullptr;
+  }
+
+  return d->windows.sources[widget.slot];
+}
+
+WidgetHandle Context::getWidget(const Window& window) const
+{
+  const auto it = d->windows.sourceSlots.find(&window);
+  if (it == d->windows.sourceSlots.end())
+  {
+    return WidgetHandle();
+  }
+
+  return WindowHandle{ it->second, d->windows.slots.getGeneration(it->second) };
+}
+
+WidgetHandle Context::getWidget(const Button& button) const
+{
+  const auto it = d->buttons.sourceSlots.find(&button);
+  if (it == d->buttons.sourceSlots.end())
+  {
+    return WidgetHandle();
+  }
+
+  return ButtonHandle{ it->second, d->buttons.slots.getGeneration(it->second) };
+}
+
+const Button* Context::getButton(WidgetHandle widget) const
+{
+  if (widget.type != WidgetHandle::Type::Button || !d->buttons.slots.isAlive(widget.slot, widget.generation))
+  {
+    return nullptr;
+  }
+
+  return d->buttons.sources[widget.slot];
+}
+
+void Context::setPointerPosition(int32_t x, int32_t y)
+{
+  d->enableSpatialIndex();
+
+  Data::PointerEvent event = d->getQueuedPointer();
+  event.x = x;
+  event.y = y;
+  d->pointerEvents.push_back(event);
+}
+
+void Context::setPointerButton(bool down)
+{
+  d->enableSpatialIndex();
+
+  Data::PointerEvent event = d->getQueuedPointer();
+  event.down = down;
+  d->pointerEvents.push_back(event);
+}
+
+WidgetHandle Context::getHoveredWidget() const
+{
+  return d->hoveredWidget;
+}
+
+WidgetHandle Context::getPressedWidget() const
+{
+  return d->pressedWidget;
+}
+
+size_t Context::getNumClickedWidgets() const
+{
+  return d->clickedWidgets.size();
+}
+
+const WidgetHandle* Context::getClickedWidgets() const
+{
+  return d->clickedWidgets.data();
+}
+
+void Context::setTraceSink(TraceSink* sink)
+{
+  d->traceSink = sink;
+}
+
+void Context::setOutputBuffers(const OutputBuffers& buffers)
 {
-  d->buttons.push_back(&button);
+  const OutputBuffers& current = d->outputBuffers;
+  const bool changed = !d->hasOutputBuffers || buffers.colorVertices != current.colorVertices ||
+                       buffers.colorVertexCapacity != current.colorVertexCapacity ||
+                       buffers.textureVertices != current.textureVertices ||
+                       buffers.textureVertexCapacity != current.textureVertexCapacity ||
+                       buffers.rectangleInstances != current.rectangleInstances ||
+                       buffers.rectangleInstanceCapacity != current.rectangleInstanceCapacity;
+  if (changed)
+  {
+    d->hasOutputBuffers = true;
+    d->outputBuffers = buffers;
+    d->layoutDirty = true;
+  }
+}
+
+void Context::clearOutputBuffers()
+{
+  if (d->hasOutputBuffers)
+  {
+    d->hasOutputBuffers = false;
+    d->outputBuffers = OutputBuffers();
+    d->layoutDirty = true;
+  }
 }
 
 void Context::processFrame()
 {
-  d->colorVertices.clear();
-  d->textureVertices.clear();
+  TraceSink::Scope frameScope(d->traceSink, "processFrame");
+  const auto frameStart = std::chrono::steady_clock::now();
+  d->frameStats = FrameStats();
+
+  // Settings that change the layout change the output even if no widget changed
+  const bool layoutChanged = d->layoutDirty;
 
-  for (const Window* window : d->windows)
+  if (d->glyphAtlas)
   {
-    const float x = static_cast<float>(window->getX());
-    const float y = static_cast<float>(window->getY());
-    const float w = static_cast<float>(window->getWidth());
-    const float h = static_cast<float>(window->getHeight());
+    d->glyphAtlas->beginFrame();
+  }
 
-    const float r = window->getColorR();
-    const float g = window->getColorG();
-    const float b = window->getColorB();
+  d->colorVertexRanges.clear();
+  d->textureVertexRanges.clear();
+  d->rectangleInstanceRanges.clear();
 
-    // clang-format off
-    d->colorVertices.push_back({ x,     y,     r, g, b });
-    d->colorVertices.push_back({ x + w, y,     r, g, b });
-    d->colorVertices.push_back({ x,     y + h, r, g, b });
+  {
+    TraceSink::Scope scope(d->traceSink, "sync");
+    d->applyCommands(*this);
+    d->windows.sync();
+    d->buttons.sync();
+    d->updateSpatialIndex();
+  }
 
-    d->colorVertices.push_back({ x + w, y,     r, g, b });
-    d->colorVertices.push_back({ x,     y + h, r, g, b });
-    d->colorVertices.push_back({ x + w, y + h, r, g, b });
-    // clang-format on
+  if (d->spatialIndex)
+  {
+    TraceSink::Scope scope(d->traceSink, "input");
+    d->processInput();
+  }
+
+  // New slots start out culled until they are found to be visible
+  {
+    Data::WindowSlot windowSlot;
+    windowSlot.visible = !d->isCulling();
+    d->windowSlots.resize(d->windows.slots.size(), windowSlot);
+
+    Data::ButtonSlot buttonSlot(d->resource);
+    buttonSlot.visible = !d->isCulling();
+    d->buttonSlots.resize(d->buttons.slots.size(), buttonSlot);
+
+    const size_t numWindowChunks = (d->windowSlots.size() + slotsPerChunk - 1u) / slotsPerChunk;
+    const size_t numButtonChunks = (d->buttonSlots.size() + slotsPerChunk - 1u) / slotsPerChunk;
+    d->chunks.resize(numWindowChunks + numButtonChunks);
+  }
+
+  if (d->isCulling())
+  {
+    TraceSink::Scope scope(d->traceSink, "visibility");
+    d->findCandidates(d->windowGrid, d->windows.slots, d->candidateWindows);
+    d->findCandidates(d->buttonGrid, d->buttons.slots, d->candidateButtons);
+
+    // What is hidden only changes with the widgets and the viewport
+    if (d->occlusionCulling &&
+        (d->occlusionDirty || !d->windows.changedSlots.empty() || !d->buttons.changedSlots.empty()))
+    {
+      d->updateOcclusion();
+    }
+
+    const bool windowsChanged = d->updateVisibility(d->candidateWindows, d->windowSlots, d->visibleWindows);
+    const bool buttonsChanged = d->updateVisibility(d->candidateButtons, d->buttonSlots, d->visibleButtons);
+    d->layoutDirty = d->layoutDirty || windowsChanged || buttonsChanged;
+
+    const size_t numWindowChunks = (d->windowSlots.size() + slotsPerChunk - 1u) / slotsPerChunk;
+    for (Data::Chunk& chunk : d->chunks)
+    {
+      chunk.culled = true;
+    }
+
+    for (const uint32_t slot : d->visibleWindows)
+    {
+      d->chunks[slot / slotsPerChunk].culled = false;
+    }
+
+    for (const uint32_t slot : d->visibleButtons)
+    {
+      d->chunks[numWindowChunks + slot / slotsPerChunk].culled = false;
+    }
+
+    d->frameStats.numWidgetsCulled = d->windows.slots.getNumAlive() - d->candidateWindows.size() +
+                                     d->buttons.slots.getNumAlive() - d->candidateButtons.size();
+    d->frameStats.numWidgetsOccluded = d->occludedNodes.size();
+  }
+
+  // New widgets, and labels that outgrew their range, force a new layout. Only widgets that changed since the last
+  // frame need to be checked.
+  if (!d->layoutDirty && d->retainedMode)
+  {
+    for (const uint32_t slot : d->windows.changedSlots)
+    {
+      const Data::WindowSlot& windowSlot = d->windowSlots[slot];
+      d->layoutDirty = d->layoutDirty ||
+                       (windowSlot.rectangle == noRectangle && windowSlot.visible && d->windows.slots.isAlive(slot));
+    }
+
+    const size_t verticesPerQuad = d->getVerticesPerQuad();
+    for (const uint32_t slot : d->buttons.changedSlots)
+    {
+      const Data::ButtonSlot& buttonSlot = d->buttonSlots[slot];
+      if (!d->layoutDirty && buttonSlot.visible && d->buttons.slots.isAlive(slot))
+      {
+        d->layoutDirty = buttonSlot.rectangle == noRectangle ||
+                         d->countLabelGlyphs(slot) * verticesPerQuad > buttonSlot.numTextureVertices;
+      }
+    }
+  }
+
+  d->rewriteAll = d->layoutDirty || !d->retainedMode;
+  if (d->rewriteAll)
+  {
+    d->layout();
   }
 
-  for (const Button* button : d->buttons)
+  // The glyph atlas is not thread safe, so new labels rasterize their glyphs up front and in slot order
+  if (d->glyphAtlas)
   {
-    // Draw the box
+    TraceSink::Scope scope(d->traceSink, "shape labels");
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t slot = 0u; slot < d->buttonSlots.size(); ++slot)
     {
-      const float x = static_cast<float>(button->getX());
-      const float y = static_cast<float>(button->getY());
-      const float w = static_cast<float>(button->getWidth());
-      const float h = static_cast<float>(button->getHeight());
+      Data::ButtonSlot& buttonSlot = d->buttonSlots[slot];
+      const std::string_view text = d->buttons.texts[slot];
+      if (buttonSlot.rectangle != noRectangle &&
+          (d->rewriteAll || d->buttons.revisions[slot] != buttonSlot.revision) &&
+          (buttonSlot.labelGeneration != d->labelGeneration || buttonSlot.labelText != text))
+      {
+        d->shapeLabel(buttonSlot, text, d->frameStats);
+      }
+    }
+
+    d->frameStats.textTime += getMilliseconds(start);
+  }
+
+  d->runTasks(d->chunks.size(), [this](size_t chunk) { d->writeChunk(chunk); });
+
+  const size_t colorVertexRangeCapacity = d->colorVertexRanges.capacity();
+  const size_t textureVertexRangeCapacity = d->textureVertexRanges.capacity();
+  const size_t rectangleInstanceRangeCapacity = d->rectangleInstanceRanges.capacity();
+  for (const Data::Chunk& chunk : d->chunks)
+  {
+    FrameStats& stats = d->frameStats;
+    stats.numWidgetsVisited += chunk.stats.numWidgetsVisited;
+    stats.numWidgetsSkipped += chunk.stats.numWidgetsSkipped;
+    stats.numGlyphs += chunk.stats.numGlyphs;
+    stats.numGlyphsDropped += chunk.stats.numGlyphsDropped;
+    stats.numReallocations += chunk.stats.numReallocations;
+    stats.windowTime += chunk.stats.windowTime;
+    stats.buttonTime += chunk.stats.buttonTime;
+    stats.textTime += chunk.stats.textTime;
 
-      const float r = 1.0f;
-      const float g = 1.0f;
-      const float b = 1.0f;
+    for (const ByteRange& range : chunk.colorVertexRanges)
+    {
+      addRange(d->colorVertexRanges, range.offset, range.size);
+    }
 
-      // clang-format off
-      d->colorVertices.push_back({ x,     y,     r, g, b });
-      d->colorVertices.push_back({ x + w, y,     r, g, b });
-      d->colorVertices.push_back({ x,     y + h, r, g, b });
+    for (const ByteRange& range : chunk.textureVertexRanges)
+    {
+      addRange(d->textureVertexRanges, range.offset, range.size);
+    }
 
-      d->colorVertices.push_back({ x + w, y,     r, g, b });
-      d->colorVertices.push_back({ x,     y + h, r, g, b });
-      d->colorVertices.push_back({ x + w, y + h, r, g, b });
-      // clang-format on
+    for (const ByteRange& range : chunk.rectangleInstanceRanges)
+    {
+      addRange(d->rectangleInstanceRanges, range.offset, range.size);
     }
+  }
+
+  d->fontTextureRegions.clear();
+  if (d->fontTextureDirty)
+  {
+    d->fontTextureRegions.push_back({ 0, 0, fontTextureSize, fontTextureSize });
+    d->fontTextureDirty = false;
+  }
 
-    // Draw the label
+  if (d->glyphAtlas)
+  {
+    // Evicted glyphs invalidate the texture coordinates of every label that was not shaped after the eviction
+    if (d->glyphAtlas->getGeneration() != d->glyphAtlasGeneration)
     {
-      float x = button->getX() + 5.0f;
-      float y = button->getY() + button->getHeight() - 5.0f;
+      TraceSink::Scope scope(d->traceSink, "relabel");
+      const auto start = std::chrono::steady_clock::now();
+      ++d->labelGeneration;
 
-      const std::string& text = button->getText();
-      for (const char& c : text)
+      Data::Chunk chunk(d->resource);
+      for (uint32_t slot = 0u; slot < d->buttonSlots.size(); ++slot)
       {
-        if (c < 32u || c >= 128u)
+        if (d->buttonSlots[slot].rectangle != noRectangle)
         {
-          continue;
+          d->writeLabel(chunk, slot);
         }
+      }
 
-        stbtt_aligned_quad quad;
-        stbtt_GetBakedQuad(d->fontCharacters, 512, 512, c - 32u, &x, &y, &quad, 1);
+      // Every label was written again
+      d->frameStats.numGlyphs = chunk.stats.numGlyphs;
+      d->frameStats.numGlyphsDropped = chunk.stats.numGlyphsDropped;
+      d->frameStats.numReallocations += chunk.stats.numReallocations;
+      d->frameStats.textTime += getMilliseconds(start);
+      d->textureVertexRanges = std::move(chunk.textureVertexRanges);
 
-        d->textureVertices.push_back({ quad.x0, quad.y0, quad.s0, quad.t0 });
-        d->textureVertices.push_back({ quad.x1, quad.y0, quad.s1, quad.t0 });
-        d->textureVertices.push_back({ quad.x0, quad.y1, quad.s0, quad.t1 });
+      d->glyphAtlasGeneration = d->glyphAtlas->getGeneration();
+    }
 
-        d->textureVertices.push_back({ quad.x1, quad.y0, quad.s1, quad.t0 });
-        d->textureVertices.push_back({ quad.x0, quad.y1, quad.s0, quad.t1 });
-        d->textureVertices.push_back({ quad.x1, quad.y1, quad.s1, quad.t1 });
-      }
+    if (d->fontTextureRegions.empty())
+    {
+      const std::vector<Rect>& dirtyRegions = d->glyphAtlas->getDirtyRegions();
+      d->fontTextureRegions.assign(dirtyRegions.begin(), dirtyRegions.end());
     }
   }
+
+  FrameStats& stats = d->frameStats;
+  stats.numReallocations += countReallocation(d->colorVertexRanges, colorVertexRangeCapacity) +
+                            countReallocation(d->textureVertexRanges, textureVertexRangeCapacity) +
+                            countReallocation(d->rectangleInstanceRanges, rectangleInstanceRangeCapacity);
+
+  for (const ByteRange& range : d->colorVertexRanges)
+  {
+    stats.numColorVertices += range.size / sizeof(ColorVertex);
+    stats.numBytesWritten += range.size;
+  }
+
+  for (const ByteRange& range : d->textureVertexRanges)
+  {
+    stats.numTextureVertices += range.size / sizeof(TextureVertex);
+    stats.numBytesWritten += range.size;
+  }
+
+  for (const ByteRange& range : d->rectangleInstanceRanges)
+  {
+    stats.numRectangleInstances += range.size / sizeof(RectangleInstance);
+    stats.numBytesWritten += range.size;
+  }
+
+  {
+    TraceSink::Scope scope(d->traceSink, "damage");
+    d->updateDamage();
+    d->windows.clearChangedSlots();
+    d->buttons.clearChangedSlots();
+  }
+
+  // Immediate mode rewrites everything, but writes the same vertices for the same widgets
+  const bool rangesWritten = !d->colorVertexRanges.empty() || !d->textureVertexRanges.empty() ||
+                             !d->rectangleInstanceRanges.empty();
+  d->frameChanged = layoutChanged || !d->damageRects.empty() || !d->fontTextureRegions.empty() ||
+                    (d->retainedMode && rangesWritten);
+
+  // The draw list only changes with the output
+  if (d->drawList && (d->frameChanged || d->drawListDirty))
+  {
+    d->buildDrawList();
+  }
+
+  stats.frameTime = getMilliseconds(frameStart);
+}
+
+FrameStats Context::getFrameStats() const
+{
+  return d->frameStats;
+}
+
+bool Context::hasOutputOverflow() const
+{
+  return d->outputOverflow;
+}
+
+bool Context::hasFrameChanged() const
+{
+  return d->frameChanged;
+}
+
+size_t Context::getNumDamageRects() const
+{
+  return d->damageRects.size();
+}
+
+const Rect* Context::getDamageRects() const
+{
+  return d->damageRects.data();
+}
+
+Rect Context::getDamageBounds() const
+{
+  return d->damageBounds;
 }
 
 size_t Context::getNumColorVertices() const
 {
-  return d->colorVertices.size();
+  return d->numColorVertices;
 }
 
 const ColorVertex* Context::getColorVertices() const
 {
-  return d->colorVertices.data();
+  return d->colorOutput;
 }
 
 size_t Context::getNumTextureVertices() const
 {
-  return d->textureVertices.size();
+  return d->numTextureVertices;
 }
 
 const TextureVertex* Context::getTextureVertices() const
 {
-  return d->textureVertices.data();
+  return d->textureOutput;
+}
+
+size_t Context::getNumRectangleInstances() const
+{
+  return d->numRectangleInstances;
+}
+
+const RectangleInstance* Context::getRectangleInstances() const
+{
+  return d->rectangleOutput;
+}
+
+size_t Context::getNumDrawCommands() const
+{
+  return d->drawCommands.size();
+}
+
+const DrawCommand* Context::getDrawCommands() const
+{
+  return d->drawCommands.data();
+}
+
+size_t Context::getNumColorIndices() const
+{
+  return d->indexType == IndexType::None ? 0u : d->numColorVertices / verticesPerIndexedQuad * 6u;
+}
+
+size_t Context::getNumTextureIndices() const
+{
+  return d->indexType == IndexType::None ? 0u : d->numTextureVertices / verticesPerIndexedQuad * 6u;
+}
+
+const void* Context::getIndices() const
+{
+  if (d->indexType == IndexType::UInt16)
+  {
+    return d->indices16.data();
+  }
+  else if (d->indexType == IndexType::UInt32)
+  {
+    return d->indices32.data();
+  }
+
+  return nullptr;
+}
+
+size_t Context::getNumColorVertexRanges() const
+{
+  return d->colorVertexRanges.size();
+}
+
+const ByteRange* Context::getColorVertexRanges() const
+{
+  return d->colorVertexRanges.data();
+}
+
+size_t Context::getNumTextureVertexRanges() const
+{
+  return d->textureVertexRanges.size();
+}
+
+const ByteRange* Context::getTextureVertexRanges() const
+{
+  return d->textureVertexRanges.data();
+}
+
+size_t Context::getNumRectangleInstanceRanges() const
+{
+  return d->rectangleInstanceRanges.size();
+}
+
+const ByteRange* Context::getRectangleInstanceRanges() const
+{
+  return d->rectangleInstanceRanges.data();
+}
+
+size_t Context::getNumFontTextureRegions() const
+{
+  return d->fontTextureRegions.size();
+}
+
+const Rect* Context::getFontTextureRegions() const
+{
+  return d->fontTextureRegions.data();
+}
+
+const unsigned char* Context::getFontTextureData() const
+{
+  return d->getFontTexture();
 }
 
-unsigned char* Context::getFontTextureData() const
+std::shared_ptr<const Font> Context::getFont() const
 {
-  return d->fontBitmap;
+  return d->font;
 }
 } // namespace ModernUI
\ No newline at end of file
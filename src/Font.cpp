@@ -0,0 +1,93 @@
+#include "FontCache.h"
+#include "FontData.h"
+
+namespace ModernUI
+{
+void Font::Data::load(const std::string& cacheDirectory)
+{
+  if (!stbtt_InitFont(&info, fontData, 0))
+  {
+    error = Context::Error::FontBakeFailed;
+    return;
+  }
+
+  if (cacheDirectory.empty())
+  {
+    if (!bake())
+    {
+      error = Context::Error::FontBakeFailed;
+    }
+
+    return;
+  }
+
+  const FontCacheKey key = { hashFontData(fontData, fontDataSize),
+                             fontPixelHeight,
+                             firstBakedCodepoint,
+                             numBakedCodepoints,
+                             fontTextureSize,
+                             fontTextureSize };
+  const std::string path = getFontCachePath(cacheDirectory, key);
+
+  const unsigned char* cachedTexture;
+  if (loadFontCache(path, key, cacheFile, cachedTexture, characters))
+  {
+    texture = cachedTexture;
+    return;
+  }
+
+  if (!bake())
+  {
+    error = Context::Error::FontBakeFailed;
+    return;
+  }
+
+  // A cache that cannot be written only costs the next launch another bake
+  saveFontCache(path, key, texture, characters);
+}
+
+bool Font::Data::bake()
+{
+  bitmap.resize(static_cast<size_t>(fontTextureSize) * fontTextureSize);
+  texture = bitmap.data();
+  characters = bakedCharacters;
+
+  return stbtt_BakeFontBitmap(fontData, 0, fontPixelHeight, bitmap.data(), fontTextureSize, fontTextureSize,
+                              firstBakedCodepoint, numBakedCodepoints, bakedCharacters) != 0;
+}
+
+Font::Font(const std::string& path, const std::string& cacheDirectory) : d(new Data)
+{
+  d->error = Context::Error::Success;
+
+  if (!d->file.open(path))
+  {
+    d->error = Context::Error::FontFileMissing;
+    return;
+  }
+
+  d->fontData = d->file.getData();
+  d->fontDataSize = d->file.getSize();
+  d->load(cacheDirectory);
+}
+
+Font::Font(const unsigned char* data, size_t size, const std::string& cacheDirectory) : d(new Data)
+{
+  d->error = Context::Error::Success;
+  d->fontData = data;
+  d->fontDataSize = size;
+  d->load(cacheDirectory);
+}
+
+Font::~Font() = default;
+
+Context::Error Font::getError() const
+{
+  return d->error;
+}
+
+const unsigned char* Font::getTextureData() const
+{
+  return d->texture;
+}
+} // namespace ModernUI
@@ -0,0 +1,183 @@
+#include "FontCache.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+  #define NOMINMAX
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#endif
+
+namespace ModernUI
+{
+namespace
+{
+constexpr char cacheMagic[8] = { 'M', 'U', 'I', 'F', 'O', 'N', 'T', '\0' };
+
+// Increase whenever the layout of the cache file or the bake itself changes
+constexpr uint32_t cacheVersion = 1u;
+
+struct CacheHeader final
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t characterSize;
+  FontCacheKey key;
+  uint64_t charactersOffset;
+  uint64_t bitmapOffset;
+};
+
+bool operator==(const FontCacheKey& a, const FontCacheKey& b)
+{
+  return a.fontHash == b.fontHash && a.pixelHeight == b.pixelHeight && a.firstCodepoint == b.firstCodepoint &&
+         a.numCodepoints == b.numCodepoints && a.textureWidth == b.textureWidth && a.textureHeight == b.textureHeight;
+}
+
+size_t getBitmapSize(const FontCacheKey& key)
+{
+  return static_cast<size_t>(key.textureWidth) * static_cast<size_t>(key.textureHeight);
+}
+
+size_t alignOffset(size_t offset)
+{
+  return (offset + 15u) & ~size_t(15u);
+}
+
+FILE* openFile(const std::string& path, const char* mode)
+{
+#if defined(_WIN32)
+  FILE* file = nullptr;
+  return fopen_s(&file, path.c_str(), mode) == 0 ? file : nullptr;
+#else
+  return fopen(path.c_str(), mode);
+#endif
+}
+
+// Readers see either the old or the new file, never none or a half written one
+bool replaceFile(const std::string& from, const std::string& to)
+{
+#if defined(_WIN32)
+  // Renaming does not replace existing files on Windows
+  return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+} // namespace
+
+uint64_t hashFontData(const unsigned char* data, size_t size)
+{
+  // FNV-1a over 64-bit words, font files are hashed on every launch so this has to be fast
+  constexpr uint64_t prime = 1099511628211ull;
+  uint64_t hash = 14695981039346656037ull ^ size;
+
+  size_t offset = 0u;
+  for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t))
+  {
+    uint64_t word;
+    memcpy(&word, &data[offset], sizeof(word));
+    hash = (hash ^ word) * prime;
+  }
+
+  for (; offset < size; ++offset)
+  {
+    hash = (hash ^ data[offset]) * prime;
+  }
+
+  return hash;
+}
+
+std::string getFontCachePath(const std::string& directory, const FontCacheKey& key)
+{
+  char name[96];
+  snprintf(name, sizeof(name), "modernui-%016llx-%g-%d-%d.fontcache", static_cast<unsigned long long>(key.fontHash),
+           key.pixelHeight, key.firstCodepoint, key.numCodepoints);
+
+  if (directory.empty() || directory.back() == '/' || directory.back() == '\\')
+  {
+    return directory + name;
+  }
+
+  return directory + '/' + name;
+}
+
+bool loadFontCache(const std::string& path,
+                   const FontCacheKey& key,
+                   MappedFile& file,
+                   const unsigned char*& bitmap,
+                   const stbtt_bakedchar*& characters)
+{
+  if (!file.open(path))
+  {
+    return false;
+  }
+
+  CacheHeader header;
+  if (file.getSize() < sizeof(header))
+  {
+    file.close();
+    return false;
+  }
+
+  memcpy(&header, file.getData(), sizeof(header));
+
+  const size_t charactersSize = static_cast<size_t>(key.numCodepoints) * sizeof(stbtt_bakedchar);
+  if (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion ||
+      header.characterSize != sizeof(stbtt_bakedchar) || !(header.key == key) ||
+      header.charactersOffset % alignof(stbtt_bakedchar) != 0u || header.charactersOffset > file.getSize() ||
+      file.getSize() - header.charactersOffset < charactersSize || header.bitmapOffset > file.getSize() ||
+      file.getSize() - header.bitmapOffset < getBitmapSize(key))
+  {
+    file.close();
+    return false;
+  }
+
+  characters = reinterpret_cast<const stbtt_bakedchar*>(file.getData() + header.charactersOffset);
+  bitmap = file.getData() + header.bitmapOffset;
+  return true;
+}
+
+bool saveFontCache(const std::string& path,
+                   const FontCacheKey& key,
+                   const unsigned char* bitmap,
+                   const stbtt_bakedchar* characters)
+{
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+  header.version = cacheVersion;
+  header.characterSize = sizeof(stbtt_bakedchar);
+  header.key = key;
+  header.charactersOffset = alignOffset(sizeof(header));
+
+  const size_t charactersSize = static_cast<size_t>(key.numCodepoints) * sizeof(stbtt_bakedchar);
+  header.bitmapOffset = alignOffset(header.charactersOffset + charactersSize);
+
+  // Write to a temporary file first, so that concurrent launches never map a half written cache
+  const std::string temporaryPath = path + ".tmp";
+  FILE* file = openFile(temporaryPath, "wb");
+  if (!file)
+  {
+    return false;
+  }
+
+  const unsigned char zeros[16] = {};
+  bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+  success = success && fwrite(zeros, 1, header.charactersOffset - sizeof(header), file) ==
+                         header.charactersOffset - sizeof(header);
+  success = success && fwrite(characters, 1, charactersSize, file) == charactersSize;
+  success = success && fwrite(zeros, 1, header.bitmapOffset - header.charactersOffset - charactersSize, file) ==
+                         header.bitmapOffset - header.charactersOffset - charactersSize;
+  success = success && fwrite(bitmap, 1, getBitmapSize(key), file) == getBitmapSize(key);
+  success = fclose(file) == 0 && success;
+
+  if (!success || !replaceFile(temporaryPath, path))
+  {
+    remove(temporaryPath.c_str());
+    return false;
+  }
+
+  return true;
+}
+} // namespace ModernUI
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <stb/stb_truetype.h>
+
+#include <cstdint>
+#include <string>
+
+namespace ModernUI
+{
+// Everything that goes into a bake, a cache file is only used if all of it matches
+struct FontCacheKey final
+{
+  uint64_t fontHash;
+  float pixelHeight;
+  int32_t firstCodepoint;
+  int32_t numCodepoints;
+  int32_t textureWidth;
+  int32_t textureHeight;
+};
+
+uint64_t hashFontData(const unsigned char* data, size_t size);
+
+std::string getFontCachePath(const std::string& directory, const FontCacheKey& key);
+
+// Maps a cache file and points the bitmap and characters into the mapping, returns false if it is missing or stale
+bool loadFontCache(const std::string& path,
+                   const FontCacheKey& key,
+                   MappedFile& file,
+                   const unsigned char*& bitmap,
+                   const stbtt_bakedchar*& characters);
+
+bool saveFontCache(const std::string& path,
+                   const FontCacheKey& key,
+                   const unsigned char* bitmap,
+                   const stbtt_bakedchar* characters);
+} // namespace ModernUI
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "ModernUI.h"
+
+#include <stb/stb_truetype.h>
+
+#include <vector>
+
+namespace ModernUI
+{
+constexpr float fontPixelHeight = 32.0f;
+constexpr int32_t fontTextureSize = 512;
+constexpr int32_t firstBakedCodepoint = 32;
+constexpr int32_t numBakedCodepoints = 96;
+
+// Distance fields reach this many texels beyond the outline of a glyph, with the outline at the edge value and the
+// value changing by the given number of steps per texel
+constexpr int32_t distanceFieldPadding = 4;
+constexpr int32_t distanceFieldEdge = 128;
+constexpr float distanceFieldSteps = 32.0f;
+
+// Never modified after construction, which is what makes sharing a font between threads safe. The texture and
+// characters either point at the bake below or into a mapped cache file.
+struct Font::Data final
+{
+  Context::Error error;
+
+  MappedFile file;
+  const unsigned char* fontData = nullptr;
+  size_t fontDataSize = 0u;
+  stbtt_fontinfo info;
+
+  MappedFile cacheFile;
+  std::vector<unsigned char> bitmap;
+  stbtt_bakedchar bakedCharacters[numBakedCodepoints];
+  const unsigned char* texture = nullptr;
+  const stbtt_bakedchar* characters = nullptr;
+
+  void load(const std::string& cacheDirectory);
+  bool bake();
+};
+} // namespace ModernUI
@@ -0,0 +1,288 @@
+#include "GlyphAtlas.h"
+
+#include "FontData.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace ModernUI
+{
+namespace
+{
+// Empty texels to the right of and below every glyph, so that linear filtering does not bleed into neighbors
+constexpr int32_t glyphPadding = 1;
+
+// Shelf heights are rounded up to this, so that glyphs of similar height share shelves
+constexpr int32_t shelfGranularity = 4;
+
+constexpr uint32_t noShelf = UINT32_MAX;
+} // namespace
+
+GlyphAtlas::GlyphAtlas(const stbtt_fontinfo& font,
+                       float pixelHeight,
+                       bool distanceField,
+                       unsigned char* bitmap,
+                       int32_t width,
+                       int32_t height)
+: font(font), scale(stbtt_ScaleForPixelHeight(&font, pixelHeight)), distanceField(distanceField), bitmap(bitmap),
+  width(width), height(height)
+{
+  memset(bitmap, 0, static_cast<size_t>(width) * height);
+}
+
+const stbtt_bakedchar* GlyphAtlas::findGlyph(uint32_t codepoint)
+{
+  const auto it = glyphs.find(codepoint);
+  if (it != glyphs.end())
+  {
+    Glyph& glyph = it->second;
+    if (glyph.lastUsedFrame != frame)
+    {
+      glyph.lastUsedFrame = frame;
+      if (glyph.shelf != noShelf)
+      {
+        leastRecentlyUsed.splice(leastRecentlyUsed.begin(), leastRecentlyUsed, glyph.leastRecentlyUsed);
+      }
+    }
+
+    return &glyph.character;
+  }
+
+  const int codepointIndex = static_cast<int>(codepoint);
+
+  // Distance fields are computed up front since that is what gives their size, which includes the padding
+  const auto freeDistanceField = [](unsigned char* field) { stbtt_FreeSDF(field, nullptr); };
+  std::unique_ptr<unsigned char, decltype(freeDistanceField)> field(nullptr, freeDistanceField);
+
+  int x0, y0, x1, y1;
+  if (distanceField)
+  {
+    int fieldWidth, fieldHeight;
+    field.reset(stbtt_GetCodepointSDF(&font, scale, codepointIndex, distanceFieldPadding, distanceFieldEdge,
+                                      distanceFieldSteps, &fieldWidth, &fieldHeight, &x0, &y0));
+    if (!field)
+    {
+      fieldWidth = fieldHeight = x0 = y0 = 0;
+    }
+
+    x1 = x0 + fieldWidth;
+    y1 = y0 + fieldHeight;
+  }
+  else
+  {
+    stbtt_GetCodepointBitmapBox(&font, codepointIndex, scale, scale, &x0, &y0, &x1, &y1);
+  }
+
+  int advance, leftSideBearing;
+  stbtt_GetCodepointHMetrics(&font, codepointIndex, &advance, &leftSideBearing);
+
+  Glyph glyph;
+  glyph.character = { 0u, 0u, 0u, 0u, static_cast<float>(x0), static_cast<float>(y0), scale * advance };
+  glyph.shelf = noShelf;
+  glyph.slot = { 0, 0 };
+  glyph.lastUsedFrame = frame;
+
+  // Glyphs without any coverage, like spaces, take up no space in the atlas
+  const int32_t glyphWidth = x1 - x0;
+  const int32_t glyphHeight = y1 - y0;
+  if (glyphWidth > 0 && glyphHeight > 0)
+  {
+    const int32_t paddedWidth = glyphWidth + glyphPadding;
+    const int32_t paddedHeight = glyphHeight + glyphPadding;
+    if (paddedWidth + glyphPadding > width || paddedHeight + glyphPadding > height)
+    {
+      return nullptr;
+    }
+
+    while (!allocate(paddedWidth, paddedHeight, glyph.shelf, glyph.slot))
+    {
+      if (!evictLeastRecentlyUsed())
+      {
+        return nullptr;
+      }
+    }
+
+    const int32_t x = glyph.slot.x;
+    const int32_t y = shelves[glyph.shelf].y;
+
+    // Clear whatever an evicted glyph left behind, then rasterize
+    for (int32_t row = 0; row < paddedHeight; ++row)
+    {
+      memset(&bitmap[static_cast<size_t>(y + row) * width + x], 0, paddedWidth);
+    }
+
+    if (field)
+    {
+      for (int32_t row = 0; row < glyphHeight; ++row)
+      {
+        memcpy(&bitmap[static_cast<size_t>(y + row) * width + x], &field.get()[row * glyphWidth], glyphWidth);
+      }
+    }
+    else
+    {
+      stbtt_MakeCodepointBitmap(&font, &bitmap[static_cast<size_t>(y) * width + x], glyphWidth, glyphHeight, width,
+                                scale, scale, codepointIndex);
+    }
+
+    addDirtyRegion({ x, y, paddedWidth, paddedHeight });
+
+    glyph.character.x0 = static_cast<unsigned short>(x);
+    glyph.character.y0 = static_cast<unsigned short>(y);
+    glyph.character.x1 = static_cast<unsigned short>(x + glyphWidth);
+    glyph.character.y1 = static_cast<unsigned short>(y + glyphHeight);
+
+    leastRecentlyUsed.push_front(codepoint);
+    glyph.leastRecentlyUsed = leastRecentlyUsed.begin();
+  }
+
+  return &glyphs.emplace(codepoint, glyph).first->second.character;
+}
+
+void GlyphAtlas::beginFrame()
+{
+  ++frame;
+  dirtyRegions.clear();
+}
+
+uint32_t GlyphAtlas::getGeneration() const
+{
+  return generation;
+}
+
+const std::vector<Rect>& GlyphAtlas::getDirtyRegions() const
+{
+  return dirtyRegions;
+}
+
+bool GlyphAtlas::allocate(int32_t width, int32_t height, uint32_t& shelf, Slot& slot)
+{
+  const int32_t shelfHeight = (height + shelfGranularity - 1) / shelfGranularity * shelfGranularity;
+
+  // First fit into a shelf of the same height, or into an empty one that is tall enough
+  for (uint32_t index = 0u; index < shelves.size(); ++index)
+  {
+    Shelf& candidate = shelves[index];
+    if (candidate.height != shelfHeight && (candidate.numGlyphs > 0u || candidate.height < shelfHeight))
+    {
+      continue;
+    }
+
+    for (auto it = candidate.freeSlots.begin(); it != candidate.freeSlots.end(); ++it)
+    {
+      if (it->width >= width)
+      {
+        slot = { it->x, width };
+        it->x += width;
+        it->width -= width;
+        if (it->width == 0)
+        {
+          candidate.freeSlots.erase(it);
+        }
+
+        ++candidate.numGlyphs;
+        shelf = index;
+        return true;
+      }
+    }
+
+    if (candidate.nextX + width <= this->width)
+    {
+      slot = { candidate.nextX, width };
+      candidate.nextX += width;
+      ++candidate.numGlyphs;
+      shelf = index;
+      return true;
+    }
+  }
+
+  // Open a new shelf below the last one
+  const int32_t top = shelves.empty() ? glyphPadding : shelves.back().y + shelves.back().height;
+  if (top + shelfHeight > this->height || glyphPadding + width > this->width)
+  {
+    return false;
+  }
+
+  shelves.push_back({ top, shelfHeight, glyphPadding + width, 1u, {} });
+  slot = { glyphPadding, width };
+  shelf = static_cast<uint32_t>(shelves.size() - 1u);
+  return true;
+}
+
+void GlyphAtlas::release(uint32_t shelf, const Slot& slot)
+{
+  Shelf& owner = shelves[shelf];
+  if (--owner.numGlyphs == 0u)
+  {
+    owner.freeSlots.clear();
+    owner.nextX = glyphPadding;
+    return;
+  }
+
+  auto it = std::lower_bound(owner.freeSlots.begin(), owner.freeSlots.end(), slot.x,
+                             [](const Slot& freeSlot, int32_t x) { return freeSlot.x < x; });
+  it = owner.freeSlots.insert(it, slot);
+
+  // Coalesce with the neighbors
+  const auto next = it + 1;
+  if (next != owner.freeSlots.end() && it->x + it->width == next->x)
+  {
+    it->width += next->width;
+    owner.freeSlots.erase(next);
+  }
+
+  if (it != owner.freeSlots.begin())
+  {
+    const auto previous = it - 1;
+    if (previous->x + previous->width == it->x)
+    {
+      previous->width += it->width;
+      owner.freeSlots.erase(it);
+    }
+  }
+
+  // Give free space at the end of the shelf back
+  if (!owner.freeSlots.empty() && owner.freeSlots.back().x + owner.freeSlots.back().width == owner.nextX)
+  {
+    owner.nextX = owner.freeSlots.back().x;
+    owner.freeSlots.pop_back();
+  }
+}
+
+bool GlyphAtlas::evictLeastRecentlyUsed()
+{
+  if (leastRecentlyUsed.empty())
+  {
+    return false;
+  }
+
+  // Everything is in use if even the least recently used glyph was used during this frame
+  const auto it = glyphs.find(leastRecentlyUsed.back());
+  if (it->second.lastUsedFrame == frame)
+  {
+    return false;
+  }
+
+  release(it->second.shelf, it->second.slot);
+  leastRecentlyUsed.pop_back();
+  glyphs.erase(it);
+  ++generation;
+  return true;
+}
+
+void GlyphAtlas::addDirtyRegion(const Rect& region)
+{
+  // Glyphs packed next to each other on a shelf are uploaded together
+  if (!dirtyRegions.empty())
+  {
+    Rect& last = dirtyRegions.back();
+    if (last.y == region.y && last.height == region.height && last.x + last.width == region.x)
+    {
+      last.width += region.width;
+      return;
+    }
+  }
+
+  dirtyRegions.push_back(region);
+}
+} // namespace ModernUI
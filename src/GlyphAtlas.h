@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ModernUI.h"
+
+#include <stb/stb_truetype.h>
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace ModernUI
+{
+// Rasterizes glyphs on first use and packs them into shelves of similar height. When the atlas is full, the least
+// recently used glyphs are evicted, but never one that was used during the current frame. Glyphs are either rasterized
+// as coverage or as signed distance fields.
+class GlyphAtlas final
+{
+public:
+  GlyphAtlas(const stbtt_fontinfo& font,
+             float pixelHeight,
+             bool distanceField,
+             unsigned char* bitmap,
+             int32_t width,
+             int32_t height);
+
+  // Returns nullptr if the glyph does not fit, even after evicting every glyph not used during the current frame
+  const stbtt_bakedchar* findGlyph(uint32_t codepoint);
+
+  void beginFrame();
+
+  // Increases whenever glyphs are evicted, which invalidates texture coordinates handed out in earlier frames
+  uint32_t getGeneration() const;
+
+  // Texture regions written since the last call to beginFrame()
+  const std::vector<Rect>& getDirtyRegions() const;
+
+private:
+  struct Slot final
+  {
+    int32_t x;
+    int32_t width;
+  };
+
+  struct Shelf final
+  {
+    int32_t y;
+    int32_t height;
+    int32_t nextX;
+    uint32_t numGlyphs;
+    std::vector<Slot> freeSlots; // Sorted by x and coalesced
+  };
+
+  struct Glyph final
+  {
+    stbtt_bakedchar character;
+    uint32_t shelf;
+    Slot slot;
+    uint64_t lastUsedFrame;
+    std::list<uint32_t>::iterator leastRecentlyUsed;
+  };
+
+  bool allocate(int32_t width, int32_t height, uint32_t& shelf, Slot& slot);
+  void release(uint32_t shelf, const Slot& slot);
+  bool evictLeastRecentlyUsed();
+  void addDirtyRegion(const Rect& region);
+
+  const stbtt_fontinfo& font;
+  float scale;
+  bool distanceField;
+  unsigned char* bitmap;
+  int32_t width, height;
+
+  uint64_t frame = 0u;
+  uint32_t generation = 0u;
+  std::unordered_map<uint32_t, Glyph> glyphs;
+  std::list<uint32_t> leastRecentlyUsed; // Codepoints of rasterized glyphs, most recently used first
+  std::vector<Shelf> shelves;
+  std::vector<Rect> dirtyRegions;
+};
+} // namespace ModernUI
@@ -0,0 +1,394 @@
+#include "Kernels.h"
+
+// The vector kernels are written for the float vertex layouts, compact builds only have the scalar ones
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && \
+  !defined(MODERNUI_COMPACT_VERTICES)
+  #define MODERNUI_X86
+
+  #include <immintrin.h>
+
+  // 32-bit builds may not enable SSE2 for the whole program, the kernels are only picked when the CPU supports it
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+    #define MODERNUI_TARGET_SSE2
+    #define MODERNUI_TARGET_AVX2
+  #else
+    #define MODERNUI_TARGET_SSE2 __attribute__((target("sse2")))
+    #define MODERNUI_TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#endif
+
+namespace ModernUI
+{
+namespace
+{
+void expandRectanglesScalar(const RectangleInput* rectangles, size_t numRectangles, ColorVertex* vertices)
+{
+  for (size_t index = 0u; index < numRectangles; ++index)
+  {
+    const RectangleInput& rectangle = rectangles[index];
+
+    const float x = static_cast<float>(rectangle.x);
+    const float y = static_cast<float>(rectangle.y);
+    const float w = static_cast<float>(rectangle.width);
+    const float h = static_cast<float>(rectangle.height);
+
+    const float r = rectangle.r;
+    const float g = rectangle.g;
+    const float b = rectangle.b;
+
+    // clang-format off
+    *vertices++ = { x,     y,     r, g, b };
+    *vertices++ = { x + w, y,     r, g, b };
+    *vertices++ = { x,     y + h, r, g, b };
+
+    *vertices++ = { x + w, y,     r, g, b };
+    *vertices++ = { x,     y + h, r, g, b };
+    *vertices++ = { x + w, y + h, r, g, b };
+    // clang-format on
+  }
+}
+
+void expandIndexedRectanglesScalar(const RectangleInput* rectangles, size_t numRectangles, ColorVertex* vertices)
+{
+  for (size_t index = 0u; index < numRectangles; ++index)
+  {
+    const RectangleInput& rectangle = rectangles[index];
+
+    const float x = static_cast<float>(rectangle.x);
+    const float y = static_cast<float>(rectangle.y);
+    const float w = static_cast<float>(rectangle.width);
+    const float h = static_cast<float>(rectangle.height);
+
+    const float r = rectangle.r;
+    const float g = rectangle.g;
+    const float b = rectangle.b;
+
+    // clang-format off
+    *vertices++ = { x,     y,     r, g, b };
+    *vertices++ = { x + w, y,     r, g, b };
+    *vertices++ = { x,     y + h, r, g, b };
+    *vertices++ = { x + w, y + h, r, g, b };
+    // clang-format on
+  }
+}
+
+void translateTextureVerticesScalar(const TextureVertex* source,
+                                    size_t numVertices,
+                                    float x,
+                                    float y,
+                                    TextureVertex* destination)
+{
+  for (size_t index = 0u; index < numVertices; ++index)
+  {
+    const TextureVertex& vertex = source[index];
+    destination[index] = { vertex.getX() + x, vertex.getY() + y, vertex.getU(), vertex.getV(), vertex.getScale() };
+  }
+}
+
+#if defined(MODERNUI_X86)
+// Picks lanes i0 and i1 from a and lanes i2 and i3 from b
+  #define MODERNUI_SHUFFLE(a, b, i0, i1, i2, i3) _mm_shuffle_ps(a, b, _MM_SHUFFLE(i3, i2, i1, i0))
+  #define MODERNUI_SHUFFLE256(a, b, i0, i1, i2, i3) _mm256_shuffle_ps(a, b, _MM_SHUFFLE(i3, i2, i1, i0))
+
+// A vertex is five floats, so the six vertices of a rectangle are the 30 floats
+//   x0 y0 r g | b x1 y0 r | g b x0 y1 | r g b x1 | y0 r g b | x0 y1 r g | b x1 y1 r | g b
+// and the four vertices of an indexed rectangle are the 20 floats
+//   x0 y0 r g | b x1 y0 r | g b x0 y1 | r g b x1 | y1 r g b
+// where every group is built from the corners c = x0 y0 x1 y1 and the color k = r g b with two shuffles at most.
+
+MODERNUI_TARGET_SSE2 void expandRectanglesSSE2(const RectangleInput* rectangles,
+                                               size_t numRectangles,
+                                               ColorVertex* vertices)
+{
+  float* output = reinterpret_cast<float*>(vertices);
+  for (size_t index = 0u; index < numRectangles; ++index)
+  {
+    const __m128 f = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&rectangles[index].x)));
+    const __m128 c = _mm_movelh_ps(f, _mm_add_ps(f, _mm_movehl_ps(f, f)));
+    const __m128 k = _mm_loadu_ps(&rectangles[index].r);
+
+    const __m128 bx1y0r = MODERNUI_SHUFFLE(k, c, 2, 0, 2, 1);
+    const __m128 bbx1x1 = MODERNUI_SHUFFLE(k, c, 2, 2, 2, 2);
+    const __m128 y0y0rr = MODERNUI_SHUFFLE(c, k, 1, 1, 0, 0);
+    const __m128 brx1y1 = MODERNUI_SHUFFLE(k, c, 2, 0, 2, 3);
+
+    _mm_storeu_ps(output + 0, MODERNUI_SHUFFLE(c, k, 0, 1, 0, 1));
+    _mm_storeu_ps(output + 4, MODERNUI_SHUFFLE(bx1y0r, bx1y0r, 0, 2, 3, 1));
+    _mm_storeu_ps(output + 8, MODERNUI_SHUFFLE(k, c, 1, 2, 0, 3));
+    _mm_storeu_ps(output + 12, MODERNUI_SHUFFLE(k, bbx1x1, 0, 1, 0, 2));
+    _mm_storeu_ps(output + 16, MODERNUI_SHUFFLE(y0y0rr, k, 0, 2, 1, 2));
+    _mm_storeu_ps(output + 20, MODERNUI_SHUFFLE(c, k, 0, 3, 0, 1));
+    _mm_storeu_ps(output + 24, MODERNUI_SHUFFLE(brx1y1, brx1y1, 0, 2, 3, 1));
+    _mm_storel_pi(reinterpret_cast<__m64*>(output + 28), MODERNUI_SHUFFLE(k, k, 1, 2, 1, 2));
+    output += 30;
+  }
+}
+
+MODERNUI_TARGET_SSE2 void expandIndexedRectanglesSSE2(const RectangleInput* rectangles,
+                                                      size_t numRectangles,
+                                                      ColorVertex* vertices)
+{
+  float* output = reinterpret_cast<float*>(vertices);
+  for (size_t index = 0u; index < numRectangles; ++index)
+  {
+    const __m128 f = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&rectangles[index].x)));
+    const __m128 c = _mm_movelh_ps(f, _mm_add_ps(f, _mm_movehl_ps(f, f)));
+    const __m128 k = _mm_loadu_ps(&rectangles[index].r);
+
+    const __m128 bx1y0r = MODERNUI_SHUFFLE(k, c, 2, 0, 2, 1);
+    const __m128 bbx1x1 = MODERNUI_SHUFFLE(k, c, 2, 2, 2, 2);
+    const __m128 y1y1rr = MODERNUI_SHUFFLE(c, k, 3, 3, 0, 0);
+
+    _mm_storeu_ps(output + 0, MODERNUI_SHUFFLE(c, k, 0, 1, 0, 1));
+    _mm_storeu_ps(output + 4, MODERNUI_SHUFFLE(bx1y0r, bx1y0r, 0, 2, 3, 1));
+    _mm_storeu_ps(output + 8, MODERNUI_SHUFFLE(k, c, 1, 2, 0, 3));
+    _mm_storeu_ps(output + 12, MODERNUI_SHUFFLE(k, bbx1x1, 0, 1, 0, 2));
+    _mm_storeu_ps(output + 16, MODERNUI_SHUFFLE(y1y1rr, k, 0, 2, 1, 2));
+    output += 20;
+  }
+}
+
+MODERNUI_TARGET_SSE2 void translateTextureVerticesSSE2(const TextureVertex* source,
+                                                       size_t numVertices,
+                                                       float x,
+                                                       float y,
+                                                       TextureVertex* destination)
+{
+  // A vertex is five floats, so four vertices are five registers that each need their own offsets. Adding negative
+  // zero leaves the texture coordinates and the scale untouched, including their sign.
+  const __m128 offset0 = _mm_setr_ps(x, y, -0.0f, -0.0f);
+  const __m128 offset1 = _mm_setr_ps(-0.0f, x, y, -0.0f);
+  const __m128 offset2 = _mm_setr_ps(-0.0f, -0.0f, x, y);
+  const __m128 offset3 = _mm_setr_ps(-0.0f, -0.0f, -0.0f, x);
+  const __m128 offset4 = _mm_setr_ps(y, -0.0f, -0.0f, -0.0f);
+  const float* input = reinterpret_cast<const float*>(source);
+  float* output = reinterpret_cast<float*>(destination);
+
+  size_t index = 0u;
+  for (; index + 4u <= numVertices; index += 4u)
+  {
+    const float* in = input + index * 5u;
+    float* out = output + index * 5u;
+    _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(in), offset0));
+    _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(in + 4), offset1));
+    _mm_storeu_ps(out + 8, _mm_add_ps(_mm_loadu_ps(in + 8), offset2));
+    _mm_storeu_ps(out + 12, _mm_add_ps(_mm_loadu_ps(in + 12), offset3));
+    _mm_storeu_ps(out + 16, _mm_add_ps(_mm_loadu_ps(in + 16), offset4));
+  }
+
+  translateTextureVerticesScalar(source + index, numVertices - index, x, y, destination + index);
+}
+
+// Two rectangles at a time, one per 128-bit lane. Shuffles work within lanes, so every group is built exactly as in
+// the SSE2 kernel.
+MODERNUI_TARGET_AVX2 void expandRectanglesAVX2(const RectangleInput* rectangles,
+                                               size_t numRectangles,
+                                               ColorVertex* vertices)
+{
+  float* output = reinterpret_cast<float*>(vertices);
+  size_t index = 0u;
+  for (; index + 2u <= numRectangles; index += 2u)
+  {
+    const __m128i* first = reinterpret_cast<const __m128i*>(&rectangles[index].x);
+    const __m128i* second = reinterpret_cast<const __m128i*>(&rectangles[index + 1u].x);
+    const __m256 f = _mm256_cvtepi32_ps(_mm256_loadu2_m128i(second, first));
+    const __m256 c = MODERNUI_SHUFFLE256(f, _mm256_add_ps(f, MODERNUI_SHUFFLE256(f, f, 2, 3, 2, 3)), 0, 1, 0, 1);
+    const __m256 k = _mm256_loadu2_m128(&rectangles[index + 1u].r, &rectangles[index].r);
+
+    const __m256 bx1y0r = MODERNUI_SHUFFLE256(k, c, 2, 0, 2, 1);
+    const __m256 bbx1x1 = MODERNUI_SHUFFLE256(k, c, 2, 2, 2, 2);
+    const __m256 y0y0rr = MODERNUI_SHUFFLE256(c, k, 1, 1, 0, 0);
+    const __m256 brx1y1 = MODERNUI_SHUFFLE256(k, c, 2, 0, 2, 3);
+
+    const __m256 groups[7] = { MODERNUI_SHUFFLE256(c, k, 0, 1, 0, 1),
+                               MODERNUI_SHUFFLE256(bx1y0r, bx1y0r, 0, 2, 3, 1),
+                               MODERNUI_SHUFFLE256(k, c, 1, 2, 0, 3),
+                               MODERNUI_SHUFFLE256(k, bbx1x1, 0, 1, 0, 2),
+                               MODERNUI_SHUFFLE256(y0y0rr, k, 0, 2, 1, 2),
+                               MODERNUI_SHUFFLE256(c, k, 0, 3, 0, 1),
+                               MODERNUI_SHUFFLE256(brx1y1, brx1y1, 0, 2, 3, 1) };
+
+    // The second rectangle starts two floats into a group, so each lane is stored on its own
+    for (size_t group = 0u; group < 7u; ++group)
+    {
+      _mm_storeu_ps(output + group * 4u, _mm256_castps256_ps128(groups[group]));
+      _mm_storeu_ps(output + 30u + group * 4u, _mm256_extractf128_ps(groups[group], 1));
+    }
+
+    const __m256 gb = MODERNUI_SHUFFLE256(k, k, 1, 2, 1, 2);
+    _mm_storel_pi(reinterpret_cast<__m64*>(output + 28), _mm256_castps256_ps128(gb));
+    _mm_storel_pi(reinterpret_cast<__m64*>(output + 58), _mm256_extractf128_ps(gb, 1));
+    output += 60;
+  }
+
+  expandRectanglesSSE2(rectangles + index, numRectangles - index, reinterpret_cast<ColorVertex*>(output));
+}
+
+MODERNUI_TARGET_AVX2 void expandIndexedRectanglesAVX2(const RectangleInput* rectangles,
+                                                      size_t numRectangles,
+                                                      ColorVertex* vertices)
+{
+  float* output = reinterpret_cast<float*>(vertices);
+  size_t index = 0u;
+  for (; index + 2u <= numRectangles; index += 2u)
+  {
+    const __m128i* first = reinterpret_cast<const __m128i*>(&rectangles[index].x);
+    const __m128i* second = reinterpret_cast<const __m128i*>(&rectangles[index + 1u].x);
+    const __m256 f = _mm256_cvtepi32_ps(_mm256_loadu2_m128i(second, first));
+    const __m256 c = MODERNUI_SHUFFLE256(f, _mm256_add_ps(f, MODERNUI_SHUFFLE256(f, f, 2, 3, 2, 3)), 0, 1, 0, 1);
+    const __m256 k = _mm256_loadu2_m128(&rectangles[index + 1u].r, &rectangles[index].r);
+
+    const __m256 bx1y0r = MODERNUI_SHUFFLE256(k, c, 2, 0, 2, 1);
+    const __m256 bbx1x1 = MODERNUI_SHUFFLE256(k, c, 2, 2, 2, 2);
+    const __m256 y1y1rr = MODERNUI_SHUFFLE256(c, k, 3, 3, 0, 0);
+
+    const __m256 group0 = MODERNUI_SHUFFLE256(c, k, 0, 1, 0, 1);
+    const __m256 group1 = MODERNUI_SHUFFLE256(bx1y0r, bx1y0r, 0, 2, 3, 1);
+    const __m256 group2 = MODERNUI_SHUFFLE256(k, c, 1, 2, 0, 3);
+    const __m256 group3 = MODERNUI_SHUFFLE256(k, bbx1x1, 0, 1, 0, 2);
+    const __m256 group4 = MODERNUI_SHUFFLE256(y1y1rr, k, 0, 2, 1, 2);
+
+    // Both rectangles are 40 floats, which regroups into five full stores
+    _mm256_storeu_ps(output + 0, _mm256_permute2f128_ps(group0, group1, 0x20));
+    _mm256_storeu_ps(output + 8, _mm256_permute2f128_ps(group2, group3, 0x20));
+    _mm256_storeu_ps(output + 16, _mm256_permute2f128_ps(group4, group0, 0x30));
+    _mm256_storeu_ps(output + 24, _mm256_permute2f128_ps(group1, group2, 0x31));
+    _mm256_storeu_ps(output + 32, _mm256_permute2f128_ps(group3, group4, 0x31));
+    output += 40;
+  }
+
+  expandIndexedRectanglesSSE2(rectangles + index, numRectangles - index, reinterpret_cast<ColorVertex*>(output));
+}
+
+MODERNUI_TARGET_AVX2 void translateTextureVerticesAVX2(const TextureVertex* source,
+                                                       size_t numVertices,
+                                                       float x,
+                                                       float y,
+                                                       TextureVertex* destination)
+{
+  // Eight vertices at a time, see the SSE2 kernel
+  const float z = -0.0f;
+  const __m256 offset0 = _mm256_setr_ps(x, y, z, z, z, x, y, z);
+  const __m256 offset1 = _mm256_setr_ps(z, z, x, y, z, z, z, x);
+  const __m256 offset2 = _mm256_setr_ps(y, z, z, z, x, y, z, z);
+  const __m256 offset3 = _mm256_setr_ps(z, x, y, z, z, z, x, y);
+  const __m256 offset4 = _mm256_setr_ps(z, z, z, x, y, z, z, z);
+  const float* input = reinterpret_cast<const float*>(source);
+  float* output = reinterpret_cast<float*>(destination);
+
+  size_t index = 0u;
+  for (; index + 8u <= numVertices; index += 8u)
+  {
+    const float* in = input + index * 5u;
+    float* out = output + index * 5u;
+    _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(in), offset0));
+    _mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(in + 8), offset1));
+    _mm256_storeu_ps(out + 16, _mm256_add_ps(_mm256_loadu_ps(in + 16), offset2));
+    _mm256_storeu_ps(out + 24, _mm256_add_ps(_mm256_loadu_ps(in + 24), offset3));
+    _mm256_storeu_ps(out + 32, _mm256_add_ps(_mm256_loadu_ps(in + 32), offset4));
+  }
+
+  translateTextureVerticesSSE2(source + index, numVertices - index, x, y, destination + index);
+}
+
+bool cpuSupportsAVX2()
+{
+  #if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+  {
+    return false;
+  }
+
+  // The OS has to save the YMM registers as well
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 6u) != 6u)
+  {
+    return false;
+  }
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+  #else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+  #endif
+}
+
+bool cpuSupportsSSE2()
+{
+  #if defined(__x86_64__) || defined(_M_X64)
+  return true;
+  #elif defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[3] & (1 << 26)) != 0;
+  #else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse2");
+  #endif
+}
+#endif
+
+constexpr Kernels scalarKernels = { expandRectanglesScalar, expandIndexedRectanglesScalar,
+                                    translateTextureVerticesScalar };
+
+#if defined(MODERNUI_X86)
+constexpr Kernels sse2Kernels = { expandRectanglesSSE2, expandIndexedRectanglesSSE2, translateTextureVerticesSSE2 };
+constexpr Kernels avx2Kernels = { expandRectanglesAVX2, expandIndexedRectanglesAVX2, translateTextureVerticesAVX2 };
+#endif
+} // namespace
+
+bool isInstructionSetSupported(Context::InstructionSet set)
+{
+#if defined(MODERNUI_X86)
+  static const bool sse2 = cpuSupportsSSE2();
+  static const bool avx2 = sse2 && cpuSupportsAVX2();
+
+  if (set == Context::InstructionSet::SSE2)
+  {
+    return sse2;
+  }
+  else if (set == Context::InstructionSet::AVX2)
+  {
+    return avx2;
+  }
+#endif
+
+  return set == Context::InstructionSet::Scalar;
+}
+
+Context::InstructionSet getBestInstructionSet()
+{
+  if (isInstructionSetSupported(Context::InstructionSet::AVX2))
+  {
+    return Context::InstructionSet::AVX2;
+  }
+  else if (isInstructionSetSupported(Context::InstructionSet::SSE2))
+  {
+    return Context::InstructionSet::SSE2;
+  }
+
+  return Context::InstructionSet::Scalar;
+}
+
+const Kernels& getKernels(Context::InstructionSet set)
+{
+#if defined(MODERNUI_X86)
+  if (set == Context::InstructionSet::AVX2)
+  {
+    return avx2Kernels;
+  }
+  else if (set == Context::InstructionSet::SSE2)
+  {
+    return sse2Kernels;
+  }
+#endif
+
+  return scalarKernels;
+}
+} // namespace ModernUI
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ModernUI.h"
+
+namespace ModernUI
+{
+// Padded to 32 bytes so that vector kernels can load the color with a single unaligned load
+struct RectangleInput final
+{
+  int32_t x, y;
+  int32_t width, height;
+  float r, g, b;
+  float padding;
+};
+
+// Batched vertex generation, every kernel set produces bit for bit the same output as the scalar one
+struct Kernels final
+{
+  // Writes six vertices per rectangle, or four when indexed
+  void (*expandRectangles)(const RectangleInput* rectangles, size_t numRectangles, ColorVertex* vertices);
+  void (*expandIndexedRectangles)(const RectangleInput* rectangles, size_t numRectangles, ColorVertex* vertices);
+
+  // Copies texture vertices while moving their positions by an offset
+  void (*translateTextureVertices)(const TextureVertex* source,
+                                   size_t numVertices,
+                                   float x,
+                                   float y,
+                                   TextureVertex* destination);
+};
+
+bool isInstructionSetSupported(Context::InstructionSet set);
+Context::InstructionSet getBestInstructionSet();
+const Kernels& getKernels(Context::InstructionSet set);
+} // namespace ModernUI
@@ -0,0 +1,286 @@
+#include "Layout.h"
+
+#include <algorithm>
+
+namespace ModernUI
+{
+namespace
+{
+int32_t clamp(int32_t value, int32_t min, int32_t max)
+{
+  // The minimum wins over a smaller maximum
+  return std::max(min, std::min(value, max));
+}
+} // namespace
+
+Layout::Layout(const WidgetTree& tree,
+               WindowStorage& windows,
+               ButtonStorage& buttons,
+               std::pmr::memory_resource* resource)
+: tree(tree), windows(windows), buttons(buttons), nodes(resource), dirtyNodes(resource)
+{
+}
+
+void Layout::setContainer(uint32_t node, Context::LayoutDirection direction, int32_t padding, int32_t spacing)
+{
+  grow(node);
+  Node& entry = nodes[node];
+  entry.direction = direction;
+  entry.padding = padding;
+  entry.spacing = spacing;
+  markDirty(node);
+}
+
+Context::LayoutDirection Layout::getDirection(uint32_t node) const
+{
+  return node < nodes.size() ? nodes[node].direction : Context::LayoutDirection::None;
+}
+
+bool Layout::isContainer(uint32_t node) const
+{
+  return getDirection(node) != Context::LayoutDirection::None;
+}
+
+bool Layout::isLaidOut(uint32_t node) const
+{
+  const uint32_t parent = tree.getParent(node);
+  return parent != WidgetTree::noNode && isContainer(parent);
+}
+
+void Layout::setSizeLimits(uint32_t node, int32_t minWidth, int32_t minHeight, int32_t maxWidth, int32_t maxHeight)
+{
+  grow(node);
+  Node& entry = nodes[node];
+  entry.minWidth = minWidth;
+  entry.minHeight = minHeight;
+  entry.maxWidth = maxWidth;
+  entry.maxHeight = maxHeight;
+  markDirty(node);
+}
+
+void Layout::setFill(uint32_t node, bool fill)
+{
+  grow(node);
+  nodes[node].fill = fill;
+  markDirty(node);
+}
+
+void Layout::setContentSize(uint32_t node, int32_t width, int32_t height)
+{
+  grow(node);
+  Node& entry = nodes[node];
+  if (entry.contentWidth != width || entry.contentHeight != height)
+  {
+    entry.contentWidth = width;
+    entry.contentHeight = height;
+    markDirty(node);
+  }
+}
+
+void Layout::markDirty(uint32_t node)
+{
+  grow(node);
+  Node& entry = nodes[node];
+  entry.measureDirty = true;
+  if (!entry.dirty)
+  {
+    entry.dirty = true;
+    dirtyNodes.push_back(node);
+  }
+}
+
+void Layout::remove(uint32_t node)
+{
+  if (node < nodes.size())
+  {
+    // Stays listed if it is, which update() handles
+    const bool dirty = nodes[node].dirty;
+    nodes[node] = Node();
+    nodes[node].dirty = dirty;
+  }
+}
+
+void Layout::update()
+{
+  // Containers measure their children, so they are dirty whenever one of their children is. The list grows while it
+  // is walked.
+  for (size_t index = 0u; index < dirtyNodes.size(); ++index)
+  {
+    const uint32_t node = dirtyNodes[index];
+    if (isLaidOut(node))
+    {
+      markDirty(tree.getParent(node));
+    }
+  }
+
+  // Branches are laid out from their topmost dirty node, widgets outside of any layout get the size that was set
+  for (const uint32_t node : dirtyNodes)
+  {
+    const WidgetStorage& storage = getStorage(node);
+    const uint32_t slot = WidgetTree::getSlot(node);
+    if (isLaidOut(node) || !storage.slots.isAlive(slot))
+    {
+      continue;
+    }
+
+    if (isContainer(node))
+    {
+      measure(node);
+      resize(node, nodes[node].measuredWidth, nodes[node].measuredHeight);
+      arrange(node);
+    }
+    else
+    {
+      resize(node, storage.preferredWidth[slot], storage.preferredHeight[slot]);
+    }
+  }
+
+  for (const uint32_t node : dirtyNodes)
+  {
+    nodes[node].dirty = false;
+  }
+
+  dirtyNodes.clear();
+}
+
+void Layout::grow(uint32_t node)
+{
+  if (node >= nodes.size())
+  {
+    nodes.resize(node + 1u);
+  }
+}
+
+WidgetStorage& Layout::getStorage(uint32_t node) const
+{
+  if (WidgetTree::isButtonNode(node))
+  {
+    return buttons;
+  }
+
+  return windows;
+}
+
+void Layout::measure(uint32_t node)
+{
+  grow(node);
+  if (!nodes[node].measureDirty)
+  {
+    return;
+  }
+
+  // Widgets are at least as large as set and as their content
+  const WidgetStorage& storage = getStorage(node);
+  const uint32_t slot = WidgetTree::getSlot(node);
+  int32_t width = std::max(storage.preferredWidth[slot], nodes[node].contentWidth);
+  int32_t height = std::max(storage.preferredHeight[slot], nodes[node].contentHeight);
+
+  if (isContainer(node))
+  {
+    const bool row = nodes[node].direction == Context::LayoutDirection::Row;
+    int32_t main = 0;
+    int32_t cross = 0;
+    int32_t numChildren = 0;
+    for (uint32_t child = tree.getFirstChild(node); child != WidgetTree::noNode; child = tree.getNextSibling(child))
+    {
+      measure(child);
+      main += row ? nodes[child].measuredWidth : nodes[child].measuredHeight;
+      cross = std::max(cross, row ? nodes[child].measuredHeight : nodes[child].measuredWidth);
+      ++numChildren;
+    }
+
+    const Node& entry = nodes[node];
+    main += std::max(numChildren - 1, 0) * entry.spacing + entry.padding * 2;
+    cross += entry.padding * 2;
+    width = std::max(width, row ? main : cross);
+    height = std::max(height, row ? cross : main);
+  }
+
+  Node& entry = nodes[node];
+  entry.measuredWidth = clamp(width, entry.minWidth, entry.maxWidth);
+  entry.measuredHeight = clamp(height, entry.minHeight, entry.maxHeight);
+  entry.measureDirty = false;
+}
+
+void Layout::arrange(uint32_t node)
+{
+  // Measuring can grow the nodes, so nothing refers into them across calls
+  const bool row = nodes[node].direction == Context::LayoutDirection::Row;
+  const int32_t padding = nodes[node].padding;
+  const int32_t spacing = nodes[node].spacing;
+
+  const WidgetStorage& storage = getStorage(node);
+  const uint32_t slot = WidgetTree::getSlot(node);
+  const int32_t innerMain = (row ? storage.width[slot] : storage.height[slot]) - padding * 2;
+  const int32_t innerCross = (row ? storage.height[slot] : storage.width[slot]) - padding * 2;
+
+  int32_t used = 0;
+  int32_t numChildren = 0;
+  int32_t numFilling = 0;
+  for (uint32_t child = tree.getFirstChild(node); child != WidgetTree::noNode; child = tree.getNextSibling(child))
+  {
+    measure(child);
+    used += row ? nodes[child].measuredWidth : nodes[child].measuredHeight;
+    numFilling += nodes[child].fill ? 1 : 0;
+    ++numChildren;
+  }
+
+  // Children that fill share the free space along the main axis and stretch across
+  used += std::max(numChildren - 1, 0) * spacing;
+  const int32_t freeSpace = std::max(innerMain - used, 0);
+
+  int32_t offset = padding;
+  int32_t fillIndex = 0;
+  for (uint32_t child = tree.getFirstChild(node); child != WidgetTree::noNode; child = tree.getNextSibling(child))
+  {
+    const Node childEntry = nodes[child];
+    int32_t main = row ? childEntry.measuredWidth : childEntry.measuredHeight;
+    int32_t cross = row ? childEntry.measuredHeight : childEntry.measuredWidth;
+    if (childEntry.fill)
+    {
+      main += freeSpace / numFilling + (fillIndex < freeSpace % numFilling ? 1 : 0);
+      main = std::min(main, row ? childEntry.maxWidth : childEntry.maxHeight);
+      cross = std::max(cross, std::min(innerCross, row ? childEntry.maxHeight : childEntry.maxWidth));
+      ++fillIndex;
+    }
+
+    place(child, row ? offset : padding, row ? padding : offset);
+    const bool resized = resize(child, row ? main : cross, row ? cross : main);
+
+    // Positions are relative to the parent, so children that only moved keep the layout of their own children
+    if (isContainer(child) && (resized || childEntry.dirty))
+    {
+      arrange(child);
+    }
+
+    offset += main + spacing;
+  }
+}
+
+void Layout::place(uint32_t node, int32_t x, int32_t y)
+{
+  WidgetStorage& storage = getStorage(node);
+  const uint32_t slot = WidgetTree::getSlot(node);
+  if (storage.localX[slot] != x || storage.localY[slot] != y)
+  {
+    storage.localX[slot] = x;
+    storage.localY[slot] = y;
+    storage.invalidate(slot);
+  }
+}
+
+bool Layout::resize(uint32_t node, int32_t width, int32_t height)
+{
+  WidgetStorage& storage = getStorage(node);
+  const uint32_t slot = WidgetTree::getSlot(node);
+  if (storage.width[slot] == width && storage.height[slot] == height)
+  {
+    return false;
+  }
+
+  storage.width[slot] = width;
+  storage.height[slot] = height;
+  storage.touch(slot);
+  return true;
+}
+} // namespace ModernUI
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ModernUI.h"
+#include "WidgetStorage.h"
+#include "WidgetTree.h"
+
+#include <memory_resource>
+#include <vector>
+
+namespace ModernUI
+{
+// Row and column layouts over the nodes of a widget tree. Containers place their children one after the other and are
+// at least large enough to fit them. Measured sizes are cached, a dirty node only invalidates the measurements of the
+// containers above it, and arranging only descends into children that are dirty or got a different size.
+class Layout final
+{
+public:
+  Layout(const WidgetTree& tree, WindowStorage& windows, ButtonStorage& buttons, std::pmr::memory_resource* resource);
+
+  void setContainer(uint32_t node, Context::LayoutDirection direction, int32_t padding, int32_t spacing);
+  Context::LayoutDirection getDirection(uint32_t node) const;
+  bool isContainer(uint32_t node) const;
+
+  // Whether the parent of the node is a container, which then positions and sizes it
+  bool isLaidOut(uint32_t node) const;
+
+  void setSizeLimits(uint32_t node, int32_t minWidth, int32_t minHeight, int32_t maxWidth, int32_t maxHeight);
+  void setFill(uint32_t node, bool fill);
+
+  // Size that the content of a node needs, such as the extents of a label
+  void setContentSize(uint32_t node, int32_t width, int32_t height);
+
+  // Lists a node whose size, content, settings or children changed
+  void markDirty(uint32_t node);
+
+  // Resets a node that is being destroyed
+  void remove(uint32_t node);
+
+  // Lays out the branches of the dirty nodes. Positions that change are written as local positions and invalidated,
+  // sizes that change are written and touched.
+  void update();
+
+private:
+  struct Node final
+  {
+    Context::LayoutDirection direction = Context::LayoutDirection::None;
+    int32_t padding = 0;
+    int32_t spacing = 0;
+
+    int32_t minWidth = 0;
+    int32_t minHeight = 0;
+    int32_t maxWidth = INT32_MAX;
+    int32_t maxHeight = INT32_MAX;
+    bool fill = false;
+
+    int32_t contentWidth = 0;
+    int32_t contentHeight = 0;
+
+    int32_t measuredWidth = 0;
+    int32_t measuredHeight = 0;
+    bool measureDirty = true;
+    bool dirty = false;
+  };
+
+  void grow(uint32_t node);
+  WidgetStorage& getStorage(uint32_t node) const;
+  void measure(uint32_t node);
+  void arrange(uint32_t node);
+  void place(uint32_t node, int32_t x, int32_t y);
+  bool resize(uint32_t node, int32_t width, int32_t height);
+
+  const WidgetTree& tree;
+  WindowStorage& windows;
+  ButtonStorage& buttons;
+
+  std::pmr::vector<Node> nodes;
+  std::pmr::vector<uint32_t> dirtyNodes;
+};
+} // namespace ModernUI
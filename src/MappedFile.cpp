@@ -0,0 +1,98 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+  #include <cstdio>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace ModernUI
+{
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+  close();
+
+#if defined(_WIN32)
+  FILE* file = nullptr;
+  if (fopen_s(&file, path.c_str(), "rb") != 0)
+  {
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  buffer.resize(static_cast<size_t>(ftell(file)));
+  fseek(file, 0, SEEK_SET);
+  const size_t numRead = fread(buffer.data(), 1, buffer.size(), file);
+  fclose(file);
+
+  if (numRead != buffer.size())
+  {
+    buffer.clear();
+    return false;
+  }
+
+  data = buffer.data();
+  size = buffer.size();
+#else
+  const int file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    return false;
+  }
+
+  struct stat status;
+  if (fstat(file, &status) != 0 || status.st_size <= 0)
+  {
+    ::close(file);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file);
+
+  if (mapping == MAP_FAILED)
+  {
+    return false;
+  }
+
+  data = static_cast<unsigned char*>(mapping);
+  size = static_cast<size_t>(status.st_size);
+  mapped = true;
+#endif
+
+  return true;
+}
+
+void MappedFile::close()
+{
+#if !defined(_WIN32)
+  if (mapped)
+  {
+    munmap(data, size);
+  }
+#endif
+
+  buffer.clear();
+  data = nullptr;
+  size = 0u;
+  mapped = false;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+  return data;
+}
+
+size_t MappedFile::getSize() const
+{
+  return size;
+}
+} // namespace ModernUI
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ModernUI
+{
+// The read-only contents of a file, memory mapped where supported and read into memory otherwise
+class MappedFile final
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+
+  const unsigned char* getData() const;
+  size_t getSize() const;
+
+private:
+  unsigned char* data = nullptr;
+  size_t size = 0u;
+  bool mapped = false;
+  std::vector<unsigned char> buffer;
+};
+} // namespace ModernUI
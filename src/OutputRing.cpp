@@ -0,0 +1,94 @@
+#include "ModernUI.h"
+
+#include <algorithm>
+
+namespace ModernUI
+{
+struct OutputRing::Data final
+{
+  OutputBuffers memory;
+  size_t numSlots;
+
+  // Slots are acquired and released in order, so the frames in flight are the ones before the current slot
+  size_t slot = 0u;
+  size_t numFramesInFlight = 0u;
+  bool acquired = false;
+};
+
+OutputRing::OutputRing(const OutputBuffers& memory, size_t numSlots) : d(std::make_unique<Data>())
+{
+  d->memory = memory;
+  d->numSlots = std::max(numSlots, size_t(1u));
+}
+
+OutputRing::~OutputRing() = default;
+
+size_t OutputRing::getNumSlots() const
+{
+  return d->numSlots;
+}
+
+size_t OutputRing::getNumFramesInFlight() const
+{
+  return d->numFramesInFlight;
+}
+
+bool OutputRing::acquire()
+{
+  if (d->numFramesInFlight == d->numSlots)
+  {
+    return false;
+  }
+
+  if (d->acquired)
+  {
+    d->slot = (d->slot + 1u) % d->numSlots;
+  }
+
+  d->acquired = true;
+  ++d->numFramesInFlight;
+  return true;
+}
+
+size_t OutputRing::getSlot() const
+{
+  return d->slot;
+}
+
+OutputBuffers OutputRing::getBuffers() const
+{
+  const OutputBuffers& memory = d->memory;
+  const size_t colorVertexCapacity = memory.colorVertexCapacity / d->numSlots;
+  const size_t textureVertexCapacity = memory.textureVertexCapacity / d->numSlots;
+  const size_t rectangleInstanceCapacity = memory.rectangleInstanceCapacity / d->numSlots;
+
+  OutputBuffers buffers;
+  if (memory.colorVertices)
+  {
+    buffers.colorVertices = memory.colorVertices + d->slot * colorVertexCapacity;
+    buffers.colorVertexCapacity = colorVertexCapacity;
+  }
+
+  if (memory.textureVertices)
+  {
+    buffers.textureVertices = memory.textureVertices + d->slot * textureVertexCapacity;
+    buffers.textureVertexCapacity = textureVertexCapacity;
+  }
+
+  if (memory.rectangleInstances)
+  {
+    buffers.rectangleInstances = memory.rectangleInstances + d->slot * rectangleInstanceCapacity;
+    buffers.rectangleInstanceCapacity = rectangleInstanceCapacity;
+  }
+
+  return buffers;
+}
+
+void OutputRing::release()
+{
+  if (d->numFramesInFlight > 0u)
+  {
+    --d->numFramesInFlight;
+  }
+}
+} // namespace ModernUI
@@ -0,0 +1,188 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+
+namespace ModernUI
+{
+namespace
+{
+// Items covering more cells than this are tested by every query instead
+constexpr int64_t maxCellsPerItem = 64;
+
+uint64_t getCellKey(int32_t x, int32_t y)
+{
+  return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32u | static_cast<uint32_t>(y);
+}
+} // namespace
+
+SpatialGrid::SpatialGrid(std::pmr::memory_resource* resource, int32_t cellShift)
+: cellShift(cellShift), items(resource), cells(resource), largeItems(resource)
+{
+}
+
+void SpatialGrid::insert(uint32_t item, const Rect& bounds)
+{
+  remove(item);
+
+  // Items without area can never overlap anything
+  if (bounds.width <= 0 || bounds.height <= 0)
+  {
+    return;
+  }
+
+  if (item >= items.size())
+  {
+    items.resize(item + 1u);
+  }
+
+  Item& entry = items[item];
+  entry.bounds = bounds;
+  entry.cells = getCells(bounds);
+  entry.inserted = true;
+
+  const int64_t numCells = (static_cast<int64_t>(entry.cells.x1) - entry.cells.x0 + 1) *
+                           (static_cast<int64_t>(entry.cells.y1) - entry.cells.y0 + 1);
+  entry.large = numCells > maxCellsPerItem;
+  if (entry.large)
+  {
+    entry.largeIndex = static_cast<uint32_t>(largeItems.size());
+    largeItems.push_back(item);
+    return;
+  }
+
+  for (int32_t y = entry.cells.y0; y <= entry.cells.y1; ++y)
+  {
+    for (int32_t x = entry.cells.x0; x <= entry.cells.x1; ++x)
+    {
+      cells[getCellKey(x, y)].push_back(item);
+    }
+  }
+}
+
+void SpatialGrid::remove(uint32_t item)
+{
+  if (item >= items.size() || !items[item].inserted)
+  {
+    return;
+  }
+
+  Item& entry = items[item];
+  entry.inserted = false;
+
+  if (entry.large)
+  {
+    const uint32_t last = largeItems.back();
+    largeItems[entry.largeIndex] = last;
+    items[last].largeIndex = entry.largeIndex;
+    largeItems.pop_back();
+    return;
+  }
+
+  for (int32_t y = entry.cells.y0; y <= entry.cells.y1; ++y)
+  {
+    for (int32_t x = entry.cells.x0; x <= entry.cells.x1; ++x)
+    {
+      const auto cell = cells.find(getCellKey(x, y));
+      std::pmr::vector<uint32_t>& cellItems = cell->second;
+      *std::find(cellItems.begin(), cellItems.end(), item) = cellItems.back();
+      cellItems.pop_back();
+    }
+  }
+}
+
+void SpatialGrid::clear()
+{
+  for (Item& entry : items)
+  {
+    entry.inserted = false;
+  }
+
+  for (auto& cell : cells)
+  {
+    cell.second.clear();
+  }
+
+  largeItems.clear();
+}
+
+void SpatialGrid::query(const Rect& rect, std::pmr::vector<uint32_t>& result) const
+{
+  if (rect.width <= 0 || rect.height <= 0)
+  {
+    return;
+  }
+
+  for (const uint32_t item : largeItems)
+  {
+    if (overlaps(items[item].bounds, rect))
+    {
+      result.push_back(item);
+    }
+  }
+
+  // An item that spans several cells is only reported by the first of them that the query visits
+  const CellRange range = getCells(rect);
+  const auto visit = [&](int32_t x, int32_t y, const std::pmr::vector<uint32_t>& cellItems) {
+    for (const uint32_t item : cellItems)
+    {
+      const Item& entry = items[item];
+      if (x == std::max(entry.cells.x0, range.x0) && y == std::max(entry.cells.y0, range.y0) &&
+          overlaps(entry.bounds, rect))
+      {
+        result.push_back(item);
+      }
+    }
+  };
+
+  // Walk whichever is smaller, the cells under the rect or the occupied cells
+  const int64_t numCells =
+    (static_cast<int64_t>(range.x1) - range.x0 + 1) * (static_cast<int64_t>(range.y1) - range.y0 + 1);
+  if (numCells > static_cast<int64_t>(cells.size()))
+  {
+    for (const auto& cell : cells)
+    {
+      const int32_t x = static_cast<int32_t>(static_cast<uint32_t>(cell.first >> 32u));
+      const int32_t y = static_cast<int32_t>(static_cast<uint32_t>(cell.first));
+      if (x >= range.x0 && x <= range.x1 && y >= range.y0 && y <= range.y1)
+      {
+        visit(x, y, cell.second);
+      }
+    }
+
+    return;
+  }
+
+  for (int32_t y = range.y0; y <= range.y1; ++y)
+  {
+    for (int32_t x = range.x0; x <= range.x1; ++x)
+    {
+      const auto cell = cells.find(getCellKey(x, y));
+      if (cell != cells.end())
+      {
+        visit(x, y, cell->second);
+      }
+    }
+  }
+}
+
+void SpatialGrid::query(int32_t x, int32_t y, std::pmr::vector<uint32_t>& result) const
+{
+  query({ x, y, 1, 1 }, result);
+}
+
+SpatialGrid::CellRange SpatialGrid::getCells(const Rect& rect) const
+{
+  const int64_t right = static_cast<int64_t>(rect.x) + rect.width - 1;
+  const int64_t bottom = static_cast<int64_t>(rect.y) + rect.height - 1;
+  return { rect.x >> cellShift, rect.y >> cellShift, static_cast<int32_t>(right >> cellShift),
+           static_cast<int32_t>(bottom >> cellShift) };
+}
+
+bool SpatialGrid::overlaps(const Rect& a, const Rect& b)
+{
+  return static_cast<int64_t>(a.x) < static_cast<int64_t>(b.x) + b.width &&
+         static_cast<int64_t>(b.x) < static_cast<int64_t>(a.x) + a.width &&
+         static_cast<int64_t>(a.y) < static_cast<int64_t>(b.y) + b.height &&
+         static_cast<int64_t>(b.y) < static_cast<int64_t>(a.y) + a.height;
+}
+} // namespace ModernUI
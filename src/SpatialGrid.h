@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ModernUI.h"
+
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+namespace ModernUI
+{
+// Uniform grid over the bounds of items, which are updated one by one as they change. Queries only visit the cells
+// they overlap, items that span many cells are kept in a separate list instead. Cells stay allocated once they were
+// used, so that items moving back and forth do not allocate.
+class SpatialGrid final
+{
+public:
+  // Cells are two to the power of the shift pixels wide and high, grids of small items query fewer of them with
+  // smaller cells
+  explicit SpatialGrid(std::pmr::memory_resource* resource, int32_t cellShift = 8);
+
+  // Inserting an item that is already in the grid moves it
+  void insert(uint32_t item, const Rect& bounds);
+  void remove(uint32_t item);
+
+  // Removes every item, the cells stay allocated
+  void clear();
+
+  // Appends every item whose bounds overlap the rect once, in no particular order
+  void query(const Rect& rect, std::pmr::vector<uint32_t>& result) const;
+
+  // Appends every item whose bounds contain the point, in no particular order
+  void query(int32_t x, int32_t y, std::pmr::vector<uint32_t>& result) const;
+
+private:
+  struct CellRange final
+  {
+    int32_t x0, y0;
+    int32_t x1, y1;
+  };
+
+  struct Item final
+  {
+    Rect bounds;
+    CellRange cells;
+    bool inserted = false;
+    bool large;
+    uint32_t largeIndex;
+  };
+
+  CellRange getCells(const Rect& rect) const;
+  static bool overlaps(const Rect& a, const Rect& b);
+
+  int32_t cellShift;
+  std::pmr::vector<Item> items;
+  std::pmr::unordered_map<uint64_t, std::pmr::vector<uint32_t>> cells;
+  std::pmr::vector<uint32_t> largeItems;
+};
+} // namespace ModernUI
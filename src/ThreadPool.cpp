@@ -0,0 +1,95 @@
+#include "ThreadPool.h"
+
+namespace ModernUI
+{
+ThreadPool::ThreadPool(size_t numThreads)
+{
+  for (size_t index = 1u; index < numThreads; ++index)
+  {
+    workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  jobStarted.notify_all();
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::getNumThreads() const
+{
+  return workers.size() + 1u;
+}
+
+void ThreadPool::run(size_t numTasks, const std::function<void(size_t)>& task)
+{
+  // Not worth waking anyone up for
+  if (workers.empty() || numTasks <= 1u)
+  {
+    for (size_t index = 0u; index < numTasks; ++index)
+    {
+      task(index);
+    }
+
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = &task;
+    this->numTasks = numTasks;
+    nextTask = 0u;
+    numBusyWorkers = workers.size();
+    ++job;
+  }
+
+  jobStarted.notify_all();
+  execute();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  jobFinished.wait(lock, [this]() { return numBusyWorkers == 0u; });
+  this->task = nullptr;
+}
+
+void ThreadPool::work()
+{
+  uint64_t lastJob = 0u;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      jobStarted.wait(lock, [this, lastJob]() { return stopping || job != lastJob; });
+      if (stopping)
+      {
+        return;
+      }
+
+      lastJob = job;
+    }
+
+    execute();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--numBusyWorkers == 0u)
+    {
+      jobFinished.notify_one();
+    }
+  }
+}
+
+void ThreadPool::execute()
+{
+  for (size_t index = nextTask++; index < numTasks; index = nextTask++)
+  {
+    (*task)(index);
+  }
+}
+} // namespace ModernUI
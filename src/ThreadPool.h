@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ModernUI
+{
+// Worker threads that run the tasks of one job at a time. Idle threads claim the next unclaimed task, so uneven tasks
+// balance out, and the calling thread works along until the job is finished.
+class ThreadPool final
+{
+public:
+  // The number of threads includes the calling thread
+  explicit ThreadPool(size_t numThreads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t getNumThreads() const;
+
+  // Runs task(0) to task(numTasks - 1) and returns once all of them finished
+  void run(size_t numTasks, const std::function<void(size_t)>& task);
+
+private:
+  void work();
+  void execute();
+
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable jobStarted, jobFinished;
+  uint64_t job = 0u;
+  size_t numBusyWorkers = 0u;
+  bool stopping = false;
+
+  const std::function<void(size_t)>* task = nullptr;
+  size_t numTasks = 0u;
+  std::atomic<size_t> nextTask{ 0u };
+};
+} // namespace ModernUI
@@ -0,0 +1,163 @@
+#include "ModernUI.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+namespace ModernUI
+{
+namespace
+{
+// Small and stable thread numbers read better in trace viewers than native ids
+uint32_t getThreadNumber()
+{
+  static std::atomic<uint32_t> numThreads{ 0u };
+  thread_local const uint32_t number = ++numThreads;
+  return number;
+}
+
+void writeString(std::ostream& stream, const char* string)
+{
+  stream << '"';
+  for (const char* c = string; *c; ++c)
+  {
+    if (*c == '"' || *c == '\\')
+    {
+      stream << '\\';
+    }
+
+    stream << *c;
+  }
+
+  stream << '"';
+}
+} // namespace
+
+struct TraceSink::Data final
+{
+  // Every field is atomic so that exporting can race with recording. The sequence is zero while an event is being
+  // written and one past its index afterwards, so that readers can tell complete events apart.
+  struct Event final
+  {
+    std::atomic<uint64_t> sequence{ 0u };
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<uint64_t> start{ 0u };
+    std::atomic<uint64_t> end{ 0u };
+    std::atomic<uint32_t> thread{ 0u };
+  };
+
+  std::chrono::steady_clock::time_point epoch;
+  std::vector<Event> events;
+  std::atomic<uint64_t> numEvents{ 0u };
+
+  explicit Data(size_t capacity) : epoch(std::chrono::steady_clock::now()), events(std::max(capacity, size_t(1u)))
+  {
+  }
+};
+
+TraceSink::Scope::Scope(TraceSink* sink, const char* name) : sink(sink), name(name), start(sink ? sink->getTime() : 0u)
+{
+}
+
+TraceSink::Scope::~Scope()
+{
+  if (sink)
+  {
+    sink->record(name, start, sink->getTime());
+  }
+}
+
+TraceSink::TraceSink(size_t capacity) : d(std::make_unique<Data>(capacity))
+{
+}
+
+TraceSink::~TraceSink() = default;
+
+uint64_t TraceSink::getTime() const
+{
+  const auto time = std::chrono::steady_clock::now() - d->epoch;
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+void TraceSink::record(const char* name, uint64_t start, uint64_t end)
+{
+  const uint64_t index = d->numEvents.fetch_add(1u, std::memory_order_relaxed);
+  Data::Event& event = d->events[index % d->events.size()];
+
+  event.sequence.store(0u, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event.name.store(name, std::memory_order_relaxed);
+  event.start.store(start, std::memory_order_relaxed);
+  event.end.store(end, std::memory_order_relaxed);
+  event.thread.store(getThreadNumber(), std::memory_order_relaxed);
+  event.sequence.store(index + 1u, std::memory_order_release);
+}
+
+size_t TraceSink::getNumEvents() const
+{
+  return static_cast<size_t>(d->numEvents.load(std::memory_order_relaxed));
+}
+
+void TraceSink::clear()
+{
+  for (Data::Event& event : d->events)
+  {
+    event.sequence.store(0u, std::memory_order_relaxed);
+  }
+
+  d->numEvents.store(0u, std::memory_order_relaxed);
+}
+
+std::string TraceSink::exportChromeTrace() const
+{
+  struct Copy final
+  {
+    uint64_t sequence;
+    const char* name;
+    uint64_t start, end;
+    uint32_t thread;
+  };
+
+  std::vector<Copy> copies;
+  copies.reserve(d->events.size());
+  for (const Data::Event& event : d->events)
+  {
+    const uint64_t sequence = event.sequence.load(std::memory_order_acquire);
+    if (sequence == 0u)
+    {
+      continue;
+    }
+
+    const Copy copy = { sequence, event.name.load(std::memory_order_relaxed),
+                        event.start.load(std::memory_order_relaxed), event.end.load(std::memory_order_relaxed),
+                        event.thread.load(std::memory_order_relaxed) };
+
+    // Overwritten while it was copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (event.sequence.load(std::memory_order_relaxed) == sequence)
+    {
+      copies.push_back(copy);
+    }
+  }
+
+  std::sort(copies.begin(), copies.end(), [](const Copy& a, const Copy& b) { return a.sequence < b.sequence; });
+
+  // Complete events with microsecond timestamps
+  std::ostringstream stream;
+  stream.precision(3);
+  stream << std::fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t index = 0u; index < copies.size(); ++index)
+  {
+    const Copy& copy = copies[index];
+    stream << (index > 0u ? ",\n" : "\n") << "{\"name\":";
+    writeString(stream, copy.name);
+    stream << ",\"cat\":\"modernui\",\"ph\":\"X\",\"pid\":1,\"tid\":" << copy.thread
+           << ",\"ts\":" << copy.start / 1000.0 << ",\"dur\":" << (copy.end - copy.start) / 1000.0 << "}";
+  }
+
+  stream << "\n]}\n";
+  return stream.str();
+}
+} // namespace ModernUI
@@ -0,0 +1,3 @@
+// The stb_truetype implementation is shared by the context and the glyph atlas
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb/stb_truetype.h>
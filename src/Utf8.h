@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ModernUI
+{
+constexpr uint32_t replacementCodepoint = 0xFFFDu;
+
+// Decodes the codepoint at the iterator and advances it, malformed sequences yield the replacement character
+inline uint32_t decodeUtf8(const char*& it, const char* end)
+{
+  const uint8_t lead = static_cast<uint8_t>(*it++);
+  if (lead < 0x80u)
+  {
+    return lead;
+  }
+
+  uint32_t codepoint;
+  uint32_t numContinuationBytes;
+  uint32_t minimum;
+  if ((lead & 0xE0u) == 0xC0u)
+  {
+    codepoint = lead & 0x1Fu;
+    numContinuationBytes = 1u;
+    minimum = 0x80u;
+  }
+  else if ((lead & 0xF0u) == 0xE0u)
+  {
+    codepoint = lead & 0x0Fu;
+    numContinuationBytes = 2u;
+    minimum = 0x800u;
+  }
+  else if ((lead & 0xF8u) == 0xF0u)
+  {
+    codepoint = lead & 0x07u;
+    numContinuationBytes = 3u;
+    minimum = 0x10000u;
+  }
+  else
+  {
+    return replacementCodepoint;
+  }
+
+  for (uint32_t index = 0u; index < numContinuationBytes; ++index)
+  {
+    if (it == end || (static_cast<uint8_t>(*it) & 0xC0u) != 0x80u)
+    {
+      return replacementCodepoint;
+    }
+
+    codepoint = (codepoint << 6u) | (static_cast<uint8_t>(*it++) & 0x3Fu);
+  }
+
+  // Reject overlong encodings, surrogates and values past the Unicode range
+  if (codepoint < minimum || (codepoint >= 0xD800u && codepoint <= 0xDFFFu) || codepoint > 0x10FFFFu)
+  {
+    return replacementCodepoint;
+  }
+
+  return codepoint;
+}
+} // namespace ModernUI
@@ -1,12 +1,206 @@
-#include "ModernUI.h"
+#include "FontData.h"
 
 namespace ModernUI
 {
+namespace
+{
+uint32_t packColorChannel(float value, uint32_t shift)
+{
+  const float clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+  return static_cast<uint32_t>(clamped * 255.0f + 0.5f) << shift;
+}
+
+float unpackColorChannel(uint32_t color, uint32_t shift)
+{
+  return static_cast<float>((color >> shift) & 0xFFu) / 255.0f;
+}
+
+#if defined(MODERNUI_COMPACT_VERTICES)
+// Positions outside of the 16-bit range are clamped
+int16_t packPosition(float value)
+{
+  const float clamped = value < -32768.0f ? -32768.0f : (value > 32767.0f ? 32767.0f : value);
+  return static_cast<int16_t>(clamped < 0.0f ? clamped - 0.5f : clamped + 0.5f);
+}
+
+uint16_t packTextureCoordinate(float value)
+{
+  const float clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+  return static_cast<uint16_t>(clamped * 65535.0f + 0.5f);
+}
+
+float unpackTextureCoordinate(uint16_t value)
+{
+  return static_cast<float>(value) / 65535.0f;
+}
+
+uint16_t packScale(float value)
+{
+  const float clamped = value < 0.0f ? 0.0f : (value > 255.99f ? 255.99f : value);
+  return static_cast<uint16_t>(clamped * 256.0f + 0.5f);
+}
+#endif
+} // namespace
+
+#if defined(MODERNUI_COMPACT_VERTICES)
+ColorVertex::ColorVertex(float x, float y, float r, float g, float b) : x(packPosition(x)), y(packPosition(y))
+{
+  color = packColorChannel(r, 0u) | packColorChannel(g, 8u) | packColorChannel(b, 16u) | (0xFFu << 24u);
+}
+
+float ColorVertex::getX() const
+{
+  return static_cast<float>(x);
+}
+
+float ColorVertex::getY() const
+{
+  return static_cast<float>(y);
+}
+
+float ColorVertex::getR() const
+{
+  return unpackColorChannel(color, 0u);
+}
+
+float ColorVertex::getG() const
+{
+  return unpackColorChannel(color, 8u);
+}
+
+float ColorVertex::getB() const
+{
+  return unpackColorChannel(color, 16u);
+}
+
+TextureVertex::TextureVertex(float x, float y, float u, float v, float scale)
+: x(packPosition(x)), y(packPosition(y)), u(packTextureCoordinate(u)), v(packTextureCoordinate(v)),
+  scale(packScale(scale))
+{
+}
+
+float TextureVertex::getX() const
+{
+  return static_cast<float>(x);
+}
+
+float TextureVertex::getY() const
+{
+  return static_cast<float>(y);
+}
+
+float TextureVertex::getU() const
+{
+  return unpackTextureCoordinate(u);
+}
+
+float TextureVertex::getV() const
+{
+  return unpackTextureCoordinate(v);
+}
+
+float TextureVertex::getScale() const
+{
+  return static_cast<float>(scale) / 256.0f;
+}
+#else
 ColorVertex::ColorVertex(float x, float y, float r, float g, float b) : x(x), y(y), r(r), g(g), b(b)
 {
 }
 
-TextureVertex::TextureVertex(float x, float y, float u, float v) : x(x), y(y), u(u), v(v)
+float ColorVertex::getX() const
+{
+  return x;
+}
+
+float ColorVertex::getY() const
+{
+  return y;
+}
+
+float ColorVertex::getR() const
+{
+  return r;
+}
+
+float ColorVertex::getG() const
+{
+  return g;
+}
+
+float ColorVertex::getB() const
+{
+  return b;
+}
+
+TextureVertex::TextureVertex(float x, float y, float u, float v, float scale) : x(x), y(y), u(u), v(v), scale(scale)
+{
+}
+
+float TextureVertex::getX() const
+{
+  return x;
+}
+
+float TextureVertex::getY() const
+{
+  return y;
+}
+
+float TextureVertex::getU() const
+{
+  return u;
+}
+
+float TextureVertex::getV() const
+{
+  return v;
+}
+
+float TextureVertex::getScale() const
+{
+  return scale;
+}
+#endif
+
+RectangleInstance::RectangleInstance(float x, float y, float width, float height, float r, float g, float b)
+: x(x), y(y), width(width), height(height)
+{
+  color = packColorChannel(r, 0u) | packColorChannel(g, 8u) | packColorChannel(b, 16u) | (0xFFu << 24u);
+}
+
+void expandRectangleInstances(const RectangleInstance* instances, size_t numInstances, ColorVertex* vertices)
+{
+  for (size_t index = 0u; index < numInstances; ++index)
+  {
+    const RectangleInstance& instance = instances[index];
+
+    const float x = instance.x;
+    const float y = instance.y;
+    const float w = instance.width;
+    const float h = instance.height;
+
+    const float r = unpackColorChannel(instance.color, 0u);
+    const float g = unpackColorChannel(instance.color, 8u);
+    const float b = unpackColorChannel(instance.color, 16u);
+
+    // clang-format off
+    *vertices++ = { x,     y,     r, g, b };
+    *vertices++ = { x + w, y,     r, g, b };
+    *vertices++ = { x,     y + h, r, g, b };
+
+    *vertices++ = { x + w, y,     r, g, b };
+    *vertices++ = { x,     y + h, r, g, b };
+    *vertices++ = { x + w, y + h, r, g, b };
+    // clang-format on
+  }
+}
+
+float shadeDistanceField(float value, float scale)
 {
+  // Positive inside, in texels and then in pixels
+  const float distance = (value * 255.0f - static_cast<float>(distanceFieldEdge)) / distanceFieldSteps;
+  const float coverage = distance * scale + 0.5f;
+  return coverage < 0.0f ? 0.0f : (coverage > 1.0f ? 1.0f : coverage);
 }
-} // namespace ModernUI
\ No newline at end of file
+} // namespace ModernUI
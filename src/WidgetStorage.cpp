@@ -0,0 +1,333 @@
+#include "WidgetStorage.h"
+
+namespace ModernUI
+{
+SlotAllocator::SlotAllocator(std::pmr::memory_resource* resource)
+: generations(resource), alive(resource), freeSlots(resource)
+{
+}
+
+uint32_t SlotAllocator::allocate()
+{
+  if (freeSlots.empty())
+  {
+    generations.push_back(0u);
+    alive.push_back(1u);
+    return static_cast<uint32_t>(generations.size() - 1u);
+  }
+
+  const uint32_t slot = freeSlots.back();
+  freeSlots.pop_back();
+  alive[slot] = 1u;
+  return slot;
+}
+
+void SlotAllocator::release(uint32_t slot)
+{
+  alive[slot] = 0u;
+  ++generations[slot];
+  freeSlots.push_back(slot);
+}
+
+bool SlotAllocator::isAlive(uint32_t slot) const
+{
+  return alive[slot] != 0u;
+}
+
+bool SlotAllocator::isAlive(uint32_t slot, uint32_t generation) const
+{
+  return slot < generations.size() && alive[slot] != 0u && generations[slot] == generation;
+}
+
+uint32_t SlotAllocator::getGeneration(uint32_t slot) const
+{
+  return generations[slot];
+}
+
+size_t SlotAllocator::size() const
+{
+  return generations.size();
+}
+
+size_t SlotAllocator::getNumAlive() const
+{
+  return generations.size() - freeSlots.size();
+}
+
+WidgetStorage::WidgetStorage(std::pmr::memory_resource* resource)
+: slots(resource), localX(resource), localY(resource), x(resource), y(resource), preferredWidth(resource),
+  preferredHeight(resource), width(resource), height(resource), revisions(resource), changedSlots(resource),
+  changed(resource), unindexedSlots(resource), unindexed(resource), unresolvedSlots(resource), unresolved(resource),
+  sourceRevisions(resource)
+{
+}
+
+uint32_t WidgetStorage::allocate(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+  const uint32_t slot = slots.allocate();
+  if (slot == this->x.size())
+  {
+    localX.push_back(x);
+    localY.push_back(y);
+    this->x.push_back(x);
+    this->y.push_back(y);
+    preferredWidth.push_back(width);
+    preferredHeight.push_back(height);
+    this->width.push_back(width);
+    this->height.push_back(height);
+    revisions.push_back(0u);
+    sourceRevisions.push_back(0u);
+    changed.push_back(0u);
+    unindexed.push_back(0u);
+    unresolved.push_back(0u);
+  }
+  else
+  {
+    localX[slot] = x;
+    localY[slot] = y;
+    this->x[slot] = x;
+    this->y[slot] = y;
+    preferredWidth[slot] = width;
+    preferredHeight[slot] = height;
+    this->width[slot] = width;
+    this->height[slot] = height;
+  }
+
+  invalidate(slot);
+  return slot;
+}
+
+void WidgetStorage::touch(uint32_t slot)
+{
+  ++revisions[slot];
+  if (!changed[slot])
+  {
+    changed[slot] = 1u;
+    changedSlots.push_back(slot);
+  }
+
+  if (!unindexed[slot])
+  {
+    unindexed[slot] = 1u;
+    unindexedSlots.push_back(slot);
+  }
+}
+
+void WidgetStorage::invalidate(uint32_t slot)
+{
+  touch(slot);
+  if (!unresolved[slot])
+  {
+    unresolved[slot] = 1u;
+    unresolvedSlots.push_back(slot);
+  }
+}
+
+void WidgetStorage::clearChangedSlots()
+{
+  for (const uint32_t slot : changedSlots)
+  {
+    changed[slot] = 0u;
+  }
+
+  changedSlots.clear();
+}
+
+void WidgetStorage::clearUnindexedSlots()
+{
+  for (const uint32_t slot : unindexedSlots)
+  {
+    unindexed[slot] = 0u;
+  }
+
+  unindexedSlots.clear();
+}
+
+void WidgetStorage::clearUnresolvedSlots()
+{
+  for (const uint32_t slot : unresolvedSlots)
+  {
+    unresolved[slot] = 0u;
+  }
+
+  unresolvedSlots.clear();
+}
+
+WindowStorage::WindowStorage(std::pmr::memory_resource* resource)
+: WidgetStorage(resource), colorR(resource), colorG(resource), colorB(resource), sources(resource),
+  sourceSlots(resource)
+{
+}
+
+uint32_t WindowStorage::create(int32_t x, int32_t y, int32_t width, int32_t height)
+{
+  const uint32_t slot = allocate(x, y, width, height);
+  if (slot == colorR.size())
+  {
+    colorR.push_back(1.0f);
+    colorG.push_back(1.0f);
+    colorB.push_back(1.0f);
+    sources.push_back(nullptr);
+  }
+  else
+  {
+    colorR[slot] = 1.0f;
+    colorG[slot] = 1.0f;
+    colorB[slot] = 1.0f;
+    sources[slot] = nullptr;
+  }
+
+  return slot;
+}
+
+uint32_t WindowStorage::add(const Window& window)
+{
+  const uint32_t slot = create(0, 0, 0, 0);
+  sources[slot] = &window;
+  sourceSlots.emplace(&window, slot);
+  copy(slot, window);
+  return slot;
+}
+
+void WindowStorage::destroy(uint32_t slot)
+{
+  // Added windows can also be destroyed through their handle, after which removing them must not find the reused slot
+  if (sources[slot])
+  {
+    const auto range = sourceSlots.equal_range(sources[slot]);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second == slot)
+      {
+        sourceSlots.erase(it);
+        break;
+      }
+    }
+  }
+
+  slots.release(slot);
+  sources[slot] = nullptr;
+  touch(slot);
+}
+
+void WindowStorage::remove(const Window& window)
+{
+  const auto it = sourceSlots.find(&window);
+  if (it != sourceSlots.end())
+  {
+    destroy(it->second);
+  }
+}
+
+void WindowStorage::sync()
+{
+  for (uint32_t slot = 0u; slot < sources.size(); ++slot)
+  {
+    const Window* window = sources[slot];
+    if (window && window->getRevision() != sourceRevisions[slot])
+    {
+      copy(slot, *window);
+    }
+  }
+}
+
+void WindowStorage::copy(uint32_t slot, const Window& window)
+{
+  localX[slot] = window.getX();
+  localY[slot] = window.getY();
+  preferredWidth[slot] = window.getWidth();
+  preferredHeight[slot] = window.getHeight();
+  colorR[slot] = window.getColorR();
+  colorG[slot] = window.getColorG();
+  colorB[slot] = window.getColorB();
+
+  sourceRevisions[slot] = window.getRevision();
+  invalidate(slot);
+}
+
+ButtonStorage::ButtonStorage(std::pmr::memory_resource* resource)
+: WidgetStorage(resource), texts(resource), sources(resource), sourceSlots(resource)
+{
+}
+
+uint32_t ButtonStorage::create(std::string_view text, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+  const uint32_t slot = allocate(x, y, width, height);
+  if (slot == texts.size())
+  {
+    texts.emplace_back(text);
+    sources.push_back(nullptr);
+  }
+  else
+  {
+    texts[slot] = text;
+    sources[slot] = nullptr;
+  }
+
+  return slot;
+}
+
+uint32_t ButtonStorage::add(const Button& button)
+{
+  const uint32_t slot = create(std::string_view(), 0, 0, 0, 0);
+  sources[slot] = &button;
+  sourceSlots.emplace(&button, slot);
+  copy(slot, button);
+  return slot;
+}
+
+void ButtonStorage::destroy(uint32_t slot)
+{
+  // Added buttons can also be destroyed through their handle, after which removing them must not find the reused slot
+  if (sources[slot])
+  {
+    const auto range = sourceSlots.equal_range(sources[slot]);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second == slot)
+      {
+        sourceSlots.erase(it);
+        break;
+      }
+    }
+  }
+
+  slots.release(slot);
+  sources[slot] = nullptr;
+  texts[slot].clear();
+  touch(slot);
+}
+
+void ButtonStorage::remove(const Button& button)
+{
+  const auto it = sourceSlots.find(&button);
+  if (it != sourceSlots.end())
+  {
+    destroy(it->second);
+  }
+}
+
+void ButtonStorage::sync()
+{
+  for (uint32_t slot = 0u; slot < sources.size(); ++slot)
+  {
+    const Button* button = sources[slot];
+    if (button && button->getRevision() != sourceRevisions[slot])
+    {
+      copy(slot, *button);
+    }
+  }
+}
+
+void ButtonStorage::copy(uint32_t slot, const Button& button)
+{
+  texts[slot] = button.getText();
+  localX[slot] = button.getX();
+  localY[slot] = button.getY();
+  preferredWidth[slot] = button.getWidth();
+  preferredHeight[slot] = button.getHeight();
+
+  sourceRevisions[slot] = button.getRevision();
+  invalidate(slot);
+}
+} // namespace ModernUI
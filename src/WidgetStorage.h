@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ModernUI.h"
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ModernUI
+{
+// Generational slots, released slots are reused first and their generation is increased so that old handles no longer
+// match them
+class SlotAllocator final
+{
+public:
+  explicit SlotAllocator(std::pmr::memory_resource* resource);
+
+  // Returns the allocated slot, which is one past the last slot if none was free
+  uint32_t allocate();
+  void release(uint32_t slot);
+
+  bool isAlive(uint32_t slot) const;
+  bool isAlive(uint32_t slot, uint32_t generation) const;
+  uint32_t getGeneration(uint32_t slot) const;
+
+  size_t size() const;
+  size_t getNumAlive() const;
+
+private:
+  std::pmr::vector<uint32_t> generations;
+  std::pmr::vector<uint8_t> alive;
+  std::pmr::vector<uint32_t> freeSlots;
+};
+
+// Properties that all widgets share, stored as structure of arrays indexed by slot so that frames walk them linearly
+struct WidgetStorage
+{
+  explicit WidgetStorage(std::pmr::memory_resource* resource);
+
+  SlotAllocator slots;
+
+  // Positions relative to the parent window, or to the origin for widgets without one, and the absolute positions they
+  // resolve to
+  std::pmr::vector<int32_t> localX, localY;
+  std::pmr::vector<int32_t> x, y;
+
+  // Sizes as set, and the sizes they resolve to which differ for widgets that are laid out
+  std::pmr::vector<int32_t> preferredWidth, preferredHeight;
+  std::pmr::vector<int32_t> width, height;
+
+  // Increased whenever a widget changes, including its creation and destruction
+  std::pmr::vector<uint32_t> revisions;
+
+  // Slots that changed since the lists were last cleared, each one listed once. Frames, the spatial index and layout
+  // consume them at different times.
+  std::pmr::vector<uint32_t> changedSlots;
+  std::pmr::vector<uint8_t> changed;
+  std::pmr::vector<uint32_t> unindexedSlots;
+  std::pmr::vector<uint8_t> unindexed;
+  std::pmr::vector<uint32_t> unresolvedSlots;
+  std::pmr::vector<uint8_t> unresolved;
+
+  // Revision of the Window or Button a slot mirrors, widgets created from handles have none
+  std::pmr::vector<uint32_t> sourceRevisions;
+
+  // Increases the revision of a slot and lists it as changed
+  void touch(uint32_t slot);
+  void clearChangedSlots();
+  void clearUnindexedSlots();
+  void clearUnresolvedSlots();
+
+  // Touches a slot whose position, size, text or parent changed and lists it, so that its layout and absolute position
+  // are resolved again
+  void invalidate(uint32_t slot);
+
+protected:
+  uint32_t allocate(int32_t x, int32_t y, int32_t width, int32_t height);
+};
+
+struct WindowStorage final : WidgetStorage
+{
+  explicit WindowStorage(std::pmr::memory_resource* resource);
+
+  std::pmr::vector<float> colorR, colorG, colorB;
+  std::pmr::vector<const Window*> sources;
+  std::pmr::unordered_multimap<const Window*, uint32_t> sourceSlots;
+
+  uint32_t create(int32_t x, int32_t y, int32_t width, int32_t height);
+  uint32_t add(const Window& window);
+  void destroy(uint32_t slot);
+  void remove(const Window& window);
+
+  // Copies the properties of every added window that changed since the last call
+  void sync();
+
+private:
+  void copy(uint32_t slot, const Window& window);
+};
+
+struct ButtonStorage final : WidgetStorage
+{
+  explicit ButtonStorage(std::pmr::memory_resource* resource);
+
+  std::pmr::vector<std::pmr::string> texts;
+  std::pmr::vector<const Button*> sources;
+  std::pmr::unordered_multimap<const Button*, uint32_t> sourceSlots;
+
+  uint32_t create(std::string_view text, int32_t x, int32_t y, int32_t width, int32_t height);
+  uint32_t add(const Button& button);
+  void destroy(uint32_t slot);
+  void remove(const Button& button);
+
+  // Copies the properties of every added button that changed since the last call
+  void sync();
+
+private:
+  void copy(uint32_t slot, const Button& button);
+};
+} // namespace ModernUI
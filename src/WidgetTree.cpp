@@ -0,0 +1,250 @@
+#include "WidgetTree.h"
+
+#include <algorithm>
+
+namespace ModernUI
+{
+uint32_t WidgetTree::getWindowNode(uint32_t slot)
+{
+  return slot * 2u;
+}
+
+uint32_t WidgetTree::getButtonNode(uint32_t slot)
+{
+  return slot * 2u + 1u;
+}
+
+bool WidgetTree::isButtonNode(uint32_t node)
+{
+  return (node & 1u) != 0u;
+}
+
+uint32_t WidgetTree::getSlot(uint32_t node)
+{
+  return node / 2u;
+}
+
+WidgetTree::WidgetTree(std::pmr::memory_resource* resource) : nodes(resource), order(resource), movedNodes(resource)
+{
+}
+
+bool WidgetTree::setParent(uint32_t node, uint32_t parent)
+{
+  grow(node);
+  if (parent != noNode)
+  {
+    grow(parent);
+
+    // Parents can not be their own ancestors
+    for (uint32_t ancestor = parent; ancestor != noNode; ancestor = nodes[ancestor].parent)
+    {
+      if (ancestor == node)
+      {
+        return false;
+      }
+    }
+  }
+
+  if (nodes[node].parent == parent)
+  {
+    return true;
+  }
+
+  unlink(node);
+  if (parent != noNode)
+  {
+    Node& entry = nodes[node];
+    Node& parentEntry = nodes[parent];
+    entry.parent = parent;
+    entry.previousSibling = parentEntry.lastChild;
+    if (parentEntry.lastChild != noNode)
+    {
+      nodes[parentEntry.lastChild].nextSibling = node;
+    }
+    else
+    {
+      parentEntry.firstChild = node;
+    }
+
+    parentEntry.lastChild = node;
+  }
+
+  orderDirty = true;
+  return true;
+}
+
+uint32_t WidgetTree::getParent(uint32_t node) const
+{
+  return node < nodes.size() ? nodes[node].parent : noNode;
+}
+
+uint32_t WidgetTree::getFirstChild(uint32_t node) const
+{
+  return node < nodes.size() ? nodes[node].firstChild : noNode;
+}
+
+uint32_t WidgetTree::getNextSibling(uint32_t node) const
+{
+  return node < nodes.size() ? nodes[node].nextSibling : noNode;
+}
+
+void WidgetTree::remove(uint32_t node)
+{
+  if (!isLinked(node))
+  {
+    return;
+  }
+
+  unlink(node);
+
+  Node& entry = nodes[node];
+  uint32_t child = entry.firstChild;
+  while (child != noNode)
+  {
+    Node& childEntry = nodes[child];
+    const uint32_t next = childEntry.nextSibling;
+    childEntry.parent = noNode;
+    childEntry.previousSibling = noNode;
+    childEntry.nextSibling = noNode;
+    child = next;
+  }
+
+  entry.firstChild = noNode;
+  entry.lastChild = noNode;
+  orderDirty = true;
+}
+
+bool WidgetTree::isLinked(uint32_t node) const
+{
+  return node < nodes.size() && (nodes[node].parent != noNode || nodes[node].firstChild != noNode);
+}
+
+void WidgetTree::markMoved(uint32_t node)
+{
+  grow(node);
+  if (!nodes[node].moved)
+  {
+    nodes[node].moved = true;
+    movedNodes.push_back(node);
+  }
+}
+
+void WidgetTree::resolve(std::pmr::vector<uint32_t>& result)
+{
+  if (orderDirty)
+  {
+    updateOrder();
+  }
+
+  std::sort(movedNodes.begin(), movedNodes.end(),
+            [this](uint32_t a, uint32_t b) { return nodes[a].orderIndex < nodes[b].orderIndex; });
+
+  // Subtrees either nest or do not overlap, so a moved node inside the last listed subtree is already covered
+  uint32_t end = 0u;
+  for (const uint32_t node : movedNodes)
+  {
+    Node& entry = nodes[node];
+    entry.moved = false;
+    if (entry.orderIndex == noNode || entry.orderIndex < end)
+    {
+      continue;
+    }
+
+    end = entry.orderIndex + entry.subtreeSize;
+    result.insert(result.end(), order.begin() + entry.orderIndex, order.begin() + end);
+  }
+
+  movedNodes.clear();
+}
+
+void WidgetTree::grow(uint32_t node)
+{
+  if (node >= nodes.size())
+  {
+    nodes.resize(node + 1u);
+  }
+}
+
+void WidgetTree::unlink(uint32_t node)
+{
+  Node& entry = nodes[node];
+  if (entry.parent == noNode)
+  {
+    return;
+  }
+
+  Node& parentEntry = nodes[entry.parent];
+  if (entry.previousSibling != noNode)
+  {
+    nodes[entry.previousSibling].nextSibling = entry.nextSibling;
+  }
+  else
+  {
+    parentEntry.firstChild = entry.nextSibling;
+  }
+
+  if (entry.nextSibling != noNode)
+  {
+    nodes[entry.nextSibling].previousSibling = entry.previousSibling;
+  }
+  else
+  {
+    parentEntry.lastChild = entry.previousSibling;
+  }
+
+  entry.parent = noNode;
+  entry.previousSibling = noNode;
+  entry.nextSibling = noNode;
+}
+
+void WidgetTree::updateOrder()
+{
+  order.clear();
+  for (Node& entry : nodes)
+  {
+    entry.orderIndex = noNode;
+  }
+
+  for (uint32_t root = 0u; root < nodes.size(); ++root)
+  {
+    if (nodes[root].parent != noNode || nodes[root].firstChild == noNode)
+    {
+      continue;
+    }
+
+    // Walks the links depth first, a subtree is complete once the walk leaves it
+    uint32_t node = root;
+    while (node != noNode)
+    {
+      nodes[node].orderIndex = static_cast<uint32_t>(order.size());
+      order.push_back(node);
+      if (nodes[node].firstChild != noNode)
+      {
+        node = nodes[node].firstChild;
+        continue;
+      }
+
+      while (node != noNode)
+      {
+        Node& entry = nodes[node];
+        entry.subtreeSize = static_cast<uint32_t>(order.size()) - entry.orderIndex;
+        if (node == root)
+        {
+          node = noNode;
+        }
+        else if (entry.nextSibling != noNode)
+        {
+          node = entry.nextSibling;
+          break;
+        }
+        else
+        {
+          node = entry.parent;
+        }
+      }
+    }
+  }
+
+  orderDirty = false;
+}
+} // namespace ModernUI
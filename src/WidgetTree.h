@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ModernUI.h"
+
+#include <memory_resource>
+#include <vector>
+
+namespace ModernUI
+{
+// Parent links between widgets, where only windows can be parents. Linked widgets are kept in depth-first order so
+// that resolving the subtrees of moved widgets walks consecutive entries, parents before their children. Widgets are
+// nodes, the slot of a window times two or the slot of a button times two plus one.
+class WidgetTree final
+{
+public:
+  static constexpr uint32_t noNode = UINT32_MAX;
+
+  static uint32_t getWindowNode(uint32_t slot);
+  static uint32_t getButtonNode(uint32_t slot);
+  static bool isButtonNode(uint32_t node);
+  static uint32_t getSlot(uint32_t node);
+
+  explicit WidgetTree(std::pmr::memory_resource* resource);
+
+  // Returns false without changing anything if the parent is the node itself or one of its descendants. Children are
+  // appended after the existing ones, a parent of noNode unlinks the node.
+  bool setParent(uint32_t node, uint32_t parent);
+  uint32_t getParent(uint32_t node) const;
+  uint32_t getFirstChild(uint32_t node) const;
+  uint32_t getNextSibling(uint32_t node) const;
+
+  // Unlinks a node that is being destroyed, its children lose their parent
+  void remove(uint32_t node);
+
+  // Whether the node has a parent or children
+  bool isLinked(uint32_t node) const;
+
+  // Lists a moved node, its subtree is resolved by the next call to resolve()
+  void markMoved(uint32_t node);
+
+  // Appends every node in the subtrees of the moved nodes once, parents before their children, then forgets the moved
+  // nodes
+  void resolve(std::pmr::vector<uint32_t>& result);
+
+private:
+  struct Node final
+  {
+    uint32_t parent = noNode;
+    uint32_t firstChild = noNode;
+    uint32_t lastChild = noNode;
+    uint32_t nextSibling = noNode;
+    uint32_t previousSibling = noNode;
+
+    // Position in the depth-first order and the number of nodes in the subtree, including the node itself
+    uint32_t orderIndex = noNode;
+    uint32_t subtreeSize = 0u;
+    bool moved = false;
+  };
+
+  void grow(uint32_t node);
+  void unlink(uint32_t node);
+  void updateOrder();
+
+  std::pmr::vector<Node> nodes;
+  std::pmr::vector<uint32_t> order;
+  std::pmr::vector<uint32_t> movedNodes;
+  bool orderDirty = false;
+};
+} // namespace ModernUI
@@ -4,6 +4,7 @@ namespace ModernUI
 {
 struct Window::Data final
 {
+  uint32_t revision = 0u;
   int32_t x, y;
   int32_t width, height;
   float colorR, colorG, colorB;
@@ -18,6 +19,11 @@ Window::Window(int32_t x, int32_t y, int32_t width, int32_t height) : d(new Data
 
 Window::~Window() = default;
 
+uint32_t Window::getRevision() const
+{
+  return d->revision;
+}
+
 int32_t Window::getX() const
 {
   return d->x;
@@ -30,6 +36,7 @@ int32_t Window::getY() const
 
 void Window::setPosition(int32_t x, int32_t y)
 {
+  ++d->revision;
   d->x = x;
   d->y = y;
 }
@@ -46,6 +53,7 @@ int32_t Window::getHeight() const
 
 void Window::setSize(int32_t width, int32_t height)
 {
+  ++d->revision;
   d->width = width;
   d->height = height;
 }
@@ -67,6 +75,7 @@ float Window::getColorB() const
 
 void Window::setColor(float r, float g, float b)
 {
+  ++d->revision;
   d->colorR = r;
   d->colorG = g;
   d->colorB = b;
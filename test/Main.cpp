@@ -293,6 +293,9 @@ int main()
     return EXIT_FAILURE;
   }
   
+  // Draw commands stack the window and the button correctly when they overlap
+  context.setDrawList(true);
+
   ModernUI::Window win = ModernUI::Window(0, 0, 100, 100);
   win.setColor(foregroundColor.r, foregroundColor.g, foregroundColor.b);
   context.addWindow(win);
@@ -328,6 +331,15 @@ int main()
 
     constexpr GLsizei vertexSize = static_cast<GLsizei>(sizeof(ModernUI::ColorVertex));
 
+#if defined(MODERNUI_COMPACT_VERTICES)
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, vertexSize,
+                          reinterpret_cast<void*>(offsetof(ModernUI::ColorVertex, x)));
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, vertexSize,
+                          reinterpret_cast<void*>(offsetof(ModernUI::ColorVertex, color)));
+#else
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, vertexSize,
                           reinterpret_cast<void*>(offsetof(ModernUI::ColorVertex, x)));
@@ -335,6 +347,7 @@ int main()
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexSize,
                           reinterpret_cast<void*>(offsetof(ModernUI::ColorVertex, r)));
+#endif
   }
 
   // Apply the vertex definition for the texture vertex buffer
@@ -344,6 +357,15 @@ int main()
 
     constexpr GLsizei vertexSize = static_cast<GLsizei>(sizeof(ModernUI::TextureVertex));
 
+#if defined(MODERNUI_COMPACT_VERTICES)
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, vertexSize,
+                          reinterpret_cast<void*>(offsetof(ModernUI::TextureVertex, x)));
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, vertexSize,
+                          reinterpret_cast<void*>(offsetof(ModernUI::TextureVertex, u)));
+#else
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, vertexSize,
                           reinterpret_cast<void*>(offsetof(ModernUI::TextureVertex, x)));
@@ -351,6 +373,7 @@ int main()
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, vertexSize,
                           reinterpret_cast<void*>(offsetof(ModernUI::TextureVertex, u)));
+#endif
   }
 
   // Main loop
@@ -369,50 +392,44 @@ int main()
 
       glClear(GL_COLOR_BUFFER_BIT);
 
-      // Draw color vertices
+      // Update the color vertex buffer
       {
         glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[0]);
 
-        // Update the color vertex buffer
-        {
-          const GLsizeiptr totalSize =
-            static_cast<GLsizeiptr>(sizeof(ModernUI::ColorVertex) * context.getNumColorVertices());
-          const void* vertexData = static_cast<const void*>(context.getColorVertices());
-          glBufferData(GL_ARRAY_BUFFER, totalSize, vertexData, GL_DYNAMIC_DRAW);
-        }
-
-        glBindVertexArray(vertexArrays[0]);
-        glUseProgram(colorShaderProgram);
-
-        // Draw the color vertex buffer
-        {
-          const GLsizei numVertices = static_cast<GLsizei>(context.getNumColorVertices());
-          glDrawArrays(GL_TRIANGLES, 0, numVertices);
-        }
+        const GLsizeiptr totalSize =
+          static_cast<GLsizeiptr>(sizeof(ModernUI::ColorVertex) * context.getNumColorVertices());
+        const void* vertexData = static_cast<const void*>(context.getColorVertices());
+        glBufferData(GL_ARRAY_BUFFER, totalSize, vertexData, GL_DYNAMIC_DRAW);
       }
 
-      // Draw texture vertices
+      // Update the texture vertex buffer
       {
         glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[1]);
 
-        // Update the texture vertex buffer
-        {
-          const GLsizeiptr totalSize =
-            static_cast<GLsizeiptr>(sizeof(ModernUI::TextureVertex) * context.getNumTextureVertices());
-          const void* vertexData = static_cast<const void*>(context.getTextureVertices());
-          glBufferData(GL_ARRAY_BUFFER, totalSize, vertexData, GL_DYNAMIC_DRAW);
-        }
-
-        glBindVertexArray(vertexArrays[1]);
-        glUseProgram(textureShaderProgram);
+        const GLsizeiptr totalSize =
+          static_cast<GLsizeiptr>(sizeof(ModernUI::TextureVertex) * context.getNumTextureVertices());
+        const void* vertexData = static_cast<const void*>(context.getTextureVertices());
+        glBufferData(GL_ARRAY_BUFFER, totalSize, vertexData, GL_DYNAMIC_DRAW);
+      }
 
-        glBindTexture(GL_TEXTURE_2D, texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
 
-        // Draw the texture vertex buffer
+      // Draw the commands in order, switching between the color and the texture pipeline
+      for (size_t index = 0u; index < context.getNumDrawCommands(); ++index)
+      {
+        const ModernUI::DrawCommand& command = context.getDrawCommands()[index];
+        if (command.pipeline == ModernUI::DrawCommand::Pipeline::Text)
         {
-          const GLsizei numVertices = static_cast<GLsizei>(context.getNumTextureVertices());
-          glDrawArrays(GL_TRIANGLES, 0, numVertices);
+          glBindVertexArray(vertexArrays[1]);
+          glUseProgram(textureShaderProgram);
         }
+        else
+        {
+          glBindVertexArray(vertexArrays[0]);
+          glUseProgram(colorShaderProgram);
+        }
+
+        glDrawArrays(GL_TRIANGLES, static_cast<GLint>(command.first), static_cast<GLsizei>(command.count));
       }
 
       glfwSwapBuffers(window);
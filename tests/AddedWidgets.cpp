@@ -0,0 +1,84 @@
+#include "Check.h"
+
+#include <modernui/ModernUI.h>
+
+#include <memory>
+
+namespace
+{
+// Destroying an added window through its handle forgets it, so that removing it later leaves the widget that reused
+// its slot alone
+void testDestroyedWindow(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  ModernUI::Context context(font);
+  ModernUI::Window window(10, 10, 50, 50);
+  context.addWindow(window);
+  context.processFrame();
+
+  const ModernUI::WidgetHandle widget = context.getWidget(window);
+  CHECK(widget.type == ModernUI::WidgetHandle::Type::Window);
+  context.destroyWindow({ widget.slot, widget.generation });
+  CHECK(context.getWidget(window).type == ModernUI::WidgetHandle::Type::None);
+
+  const ModernUI::WindowHandle reused = context.createWindow(0, 0, 20, 20);
+  CHECK(reused.slot == widget.slot);
+  context.removeWindow(window);
+  CHECK(context.isValid(reused));
+  context.processFrame();
+  CHECK(context.isValid(reused));
+  CHECK(context.getNumColorVertices() > 0u);
+
+  // Adding it again works like the first time
+  context.addWindow(window);
+  CHECK(context.getWidget(window).type == ModernUI::WidgetHandle::Type::Window);
+  context.removeWindow(window);
+  CHECK(context.getWidget(window).type == ModernUI::WidgetHandle::Type::None);
+  CHECK(context.isValid(reused));
+}
+
+void testDestroyedButton(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  ModernUI::Context context(font);
+  ModernUI::Button button("Added", 10, 10, 80, 25);
+  context.addButton(button);
+  context.processFrame();
+
+  const ModernUI::WidgetHandle widget = context.getWidget(button);
+  CHECK(widget.type == ModernUI::WidgetHandle::Type::Button);
+  context.destroyButton({ widget.slot, widget.generation });
+  CHECK(context.getWidget(button).type == ModernUI::WidgetHandle::Type::None);
+
+  const ModernUI::ButtonHandle reused = context.createButton("Created", 0, 0, 80, 25);
+  CHECK(reused.slot == widget.slot);
+  context.removeButton(button);
+  CHECK(context.isValid(reused));
+  context.processFrame();
+  CHECK(context.isValid(reused));
+  CHECK(context.getNumTextureVertices() > 0u);
+}
+
+// The same widget added twice keeps its other slot when one of them is destroyed
+void testAddedTwice(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  ModernUI::Context context(font);
+  ModernUI::Button button("Twice", 10, 10, 80, 25);
+  context.addButton(button);
+  const ModernUI::WidgetHandle first = context.getWidget(button);
+  context.addButton(button);
+  context.destroyButton({ first.slot, first.generation });
+
+  const ModernUI::WidgetHandle second = context.getWidget(button);
+  CHECK(second.type == ModernUI::WidgetHandle::Type::Button && second.slot != first.slot);
+  context.removeButton(button);
+  CHECK(context.getWidget(button).type == ModernUI::WidgetHandle::Type::None);
+}
+} // namespace
+
+int main()
+{
+  const auto font = std::make_shared<const ModernUI::Font>(MODERNUI_TEST_FONT);
+  testDestroyedWindow(font);
+  testDestroyedButton(font);
+  testAddedTwice(font);
+  return ModernUI::Test::getResult();
+}
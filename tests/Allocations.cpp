@@ -0,0 +1,167 @@
+#include "Check.h"
+
+#include <modernui/ModernUI.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr size_t numWidgets = 500u;
+constexpr size_t numWarmUpFrames = 10u;
+constexpr size_t numCountedFrames = 20u;
+
+// Heap allocations of any thread, counted by the replaced global operator new below while frames are processed
+std::atomic<bool> counting{ false };
+std::atomic<size_t> numAllocations{ 0u };
+
+enum class Changes
+{
+  None,
+  Positions,
+  Texts
+};
+
+struct Settings final
+{
+  Changes changes;
+  bool retained;
+  bool drawList = false;
+  bool occlusionCulling = false;
+  size_t numThreads = 1u;
+};
+
+// Widgets move between two positions and labels between two texts, so that warming up reaches every size
+size_t countAllocations(const std::shared_ptr<const ModernUI::Font>& font, const Settings& settings)
+{
+  ModernUI::Context context(font);
+  context.setRetainedMode(settings.retained);
+  context.setDrawList(settings.drawList);
+  context.setOcclusionCulling(settings.occlusionCulling);
+  context.setNumThreads(settings.numThreads);
+
+  std::vector<ModernUI::WindowHandle> windows;
+  std::vector<ModernUI::ButtonHandle> buttons;
+  for (size_t index = 0u; index < numWidgets; ++index)
+  {
+    const int32_t x = static_cast<int32_t>(index % 25u) * 40;
+    const int32_t y = static_cast<int32_t>(index / 25u) * 30;
+    // Every other window is hidden behind its button
+    windows.push_back(context.createWindow(x, y, index % 2u ? 24 : 36, index % 2u ? 16 : 26));
+    buttons.push_back(context.createButton("Button", x, y, 30, 20));
+  }
+
+  size_t numFrameAllocations = 0u;
+  for (size_t frame = 0u; frame < numWarmUpFrames + numCountedFrames; ++frame)
+  {
+    for (size_t index = 0u; index < numWidgets; ++index)
+    {
+      if (settings.changes == Changes::Positions)
+      {
+        const int32_t offset = static_cast<int32_t>(frame % 2u) * 5;
+        const int32_t x = static_cast<int32_t>(index % 25u) * 40 + offset;
+        const int32_t y = static_cast<int32_t>(index / 25u) * 30 + offset;
+        context.setWindowPosition(windows[index], x, y);
+        context.setButtonPosition(buttons[index], x, y);
+      }
+      else if (settings.changes == Changes::Texts)
+      {
+        context.setButtonText(buttons[index], (frame + index) % 2u ? "Button" : "Label with more glyphs");
+      }
+    }
+
+    const size_t numAllocationsBefore = numAllocations;
+    counting = true;
+    context.processFrame();
+    counting = false;
+    if (frame >= numWarmUpFrames)
+    {
+      numFrameAllocations += numAllocations - numAllocationsBefore;
+    }
+  }
+
+  return numFrameAllocations;
+}
+} // namespace
+
+void* operator new(size_t size)
+{
+  if (counting)
+  {
+    ++numAllocations;
+  }
+
+  if (void* pointer = std::malloc(size > 0u ? size : 1u))
+  {
+    return pointer;
+  }
+
+  throw std::bad_alloc();
+}
+
+// Memory resources allocate through the aligned overloads
+void* operator new(size_t size, std::align_val_t alignment)
+{
+  if (counting)
+  {
+    ++numAllocations;
+  }
+
+  const size_t bytes = static_cast<size_t>(alignment);
+  const size_t alignedSize = (std::max(size, size_t(1u)) + bytes - 1u) / bytes * bytes;
+#if defined(_MSC_VER)
+  if (void* pointer = _aligned_malloc(alignedSize, bytes))
+#else
+  if (void* pointer = std::aligned_alloc(bytes, alignedSize))
+#endif
+  {
+    return pointer;
+  }
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+#if defined(_MSC_VER)
+  _aligned_free(pointer);
+#else
+  std::free(pointer);
+#endif
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+  operator delete(pointer, alignment);
+}
+
+int main()
+{
+  const auto font = std::make_shared<const ModernUI::Font>(MODERNUI_TEST_FONT);
+  for (const bool retained : { false, true })
+  {
+    for (const Changes changes : { Changes::None, Changes::Positions, Changes::Texts })
+    {
+      CHECK(countAllocations(font, { changes, retained }) == 0u);
+      CHECK(countAllocations(font, { changes, retained, true, true }) == 0u);
+      CHECK(countAllocations(font, { changes, retained, true, true, 3u }) == 0u);
+    }
+  }
+
+  return ModernUI::Test::getResult();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace ModernUI
+{
+namespace Test
+{
+inline int numFailures = 0;
+
+inline void check(bool condition, const char* expression, const char* file, int line)
+{
+  if (!condition)
+  {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++numFailures;
+  }
+}
+
+inline int getResult()
+{
+  return numFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+} // namespace Test
+} // namespace ModernUI
+
+// Failed checks are reported and counted, the test keeps running so that one run shows all of them
+#define CHECK(condition) ModernUI::Test::check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,246 @@
+#include "Check.h"
+
+#include <modernui/ModernUI.h>
+
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr size_t numProducers = 4u;
+constexpr size_t widgetsPerProducer = 50u;
+constexpr size_t numUpdates = 5000u;
+
+// Counts the allocations of every thread that queues changes or processes frames
+class CountingResource final : public std::pmr::memory_resource
+{
+public:
+  std::atomic<size_t> numAllocations{ 0u };
+
+private:
+  void* do_allocate(size_t bytes, size_t alignment) override
+  {
+    ++numAllocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* pointer, size_t bytes, size_t alignment) override
+  {
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+// Producers queue changes to widgets of their own and to a destroyed one while the calling thread runs frames, then the
+// last change to every widget has to be the one that stuck
+void runProducers(const std::shared_ptr<const ModernUI::Font>& font, bool retained, bool threaded)
+{
+  ModernUI::Context context(font);
+  context.setRetainedMode(retained);
+  if (threaded)
+  {
+    context.setNumThreads(3u);
+    context.setOcclusionCulling(true);
+  }
+
+  std::vector<std::vector<ModernUI::WindowHandle>> windows(numProducers);
+  std::vector<std::vector<ModernUI::ButtonHandle>> buttons(numProducers);
+  for (size_t producer = 0u; producer < numProducers; ++producer)
+  {
+    for (size_t widget = 0u; widget < widgetsPerProducer; ++widget)
+    {
+      const int32_t x = static_cast<int32_t>(widget * 10u);
+      const int32_t y = static_cast<int32_t>(producer * 50u);
+      windows[producer].push_back(context.createWindow(x, y, 20, 20));
+      buttons[producer].push_back(context.createButton("Button", x, y + 25, 40, 20));
+    }
+  }
+
+  // The slot of the destroyed button is reused, changes queued with its old handle must not reach the new button
+  const ModernUI::ButtonHandle destroyed = context.createButton("Destroyed", 0, 0, 10, 10);
+  context.destroyButton(destroyed);
+  const ModernUI::ButtonHandle reused = context.createButton("Reused", 0, 0, 10, 10);
+
+  std::atomic<size_t> numDone{ 0u };
+  std::vector<std::thread> threads;
+  for (size_t producer = 0u; producer < numProducers; ++producer)
+  {
+    threads.emplace_back(
+      [&, producer]
+      {
+        for (size_t update = 0u; update < numUpdates; ++update)
+        {
+          const size_t widget = update % widgetsPerProducer;
+          const float r = static_cast<float>(update) / static_cast<float>(numUpdates);
+          context.queueWindowColor(windows[producer][widget], r, 0.5f, static_cast<float>(producer) / 4.0f);
+          context.queueWindowPosition(windows[producer][widget], static_cast<int32_t>(update),
+                                      static_cast<int32_t>(producer));
+          context.queueButtonText(buttons[producer][widget], "Label " + std::to_string(update));
+          context.queueButtonSize(buttons[producer][widget], 40 + static_cast<int32_t>(update % 7u), 20);
+          if (update % 100u == 0u)
+          {
+            context.queueButtonText(destroyed, "Destroyed");
+            context.queueButtonPosition(destroyed, 1, 1);
+          }
+
+          if (update % 50u == 0u)
+          {
+            std::this_thread::yield();
+          }
+        }
+
+        ++numDone;
+      });
+  }
+
+  while (numDone < numProducers)
+  {
+    context.processFrame();
+  }
+
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  context.processFrame();
+
+  for (size_t producer = 0u; producer < numProducers; ++producer)
+  {
+    for (size_t widget = 0u; widget < widgetsPerProducer; ++widget)
+    {
+      const size_t lastUpdate = numUpdates - widgetsPerProducer + widget;
+      const ModernUI::Rect window = context.getWidgetBounds(windows[producer][widget]);
+      CHECK(window.x == static_cast<int32_t>(lastUpdate) && window.y == static_cast<int32_t>(producer));
+      const ModernUI::Rect button = context.getWidgetBounds(buttons[producer][widget]);
+      CHECK(button.width == 40 + static_cast<int32_t>(lastUpdate % 7u));
+    }
+  }
+
+  CHECK(context.getWidgetBounds(reused).x == 0);
+}
+
+// Changes queued by another thread have to draw the same as the setters they stand for
+void compareSetters(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  ModernUI::Context direct(font), queued(font);
+  const ModernUI::WindowHandle directWindow = direct.createWindow(0, 0, 10, 10);
+  const ModernUI::WindowHandle queuedWindow = queued.createWindow(0, 0, 10, 10);
+  const ModernUI::ButtonHandle directButton = direct.createButton("Button", 0, 0, 50, 20);
+  const ModernUI::ButtonHandle queuedButton = queued.createButton("Button", 0, 0, 50, 20);
+  direct.processFrame();
+  queued.processFrame();
+
+  direct.setWindowColor(directWindow, 1.0f, 0.0f, 0.0f);
+  direct.setButtonText(directButton, "Hello");
+  direct.setWindowSize(directWindow, 30, 40);
+  direct.setButtonPosition(directButton, 5, 6);
+  direct.setWindowPosition(directWindow, 7, 8);
+  direct.setButtonSize(directButton, 60, 25);
+
+  std::thread producer(
+    [&]
+    {
+      queued.queueWindowColor(queuedWindow, 1.0f, 0.0f, 0.0f);
+      queued.queueButtonText(queuedButton, "Hello");
+      queued.queueWindowSize(queuedWindow, 30, 40);
+      queued.queueButtonPosition(queuedButton, 5, 6);
+      queued.queueWindowPosition(queuedWindow, 7, 8);
+      queued.queueButtonSize(queuedButton, 60, 25);
+    });
+  producer.join();
+
+  direct.processFrame();
+  queued.processFrame();
+
+  CHECK(direct.getNumColorVertices() == queued.getNumColorVertices());
+  CHECK(direct.getNumTextureVertices() == queued.getNumTextureVertices());
+  if (direct.getNumColorVertices() == queued.getNumColorVertices())
+  {
+    for (size_t index = 0u; index < direct.getNumColorVertices(); ++index)
+    {
+      const ModernUI::ColorVertex& expected = direct.getColorVertices()[index];
+      const ModernUI::ColorVertex& vertex = queued.getColorVertices()[index];
+      CHECK(vertex.getX() == expected.getX() && vertex.getY() == expected.getY() && vertex.getR() == expected.getR());
+    }
+  }
+
+  if (direct.getNumTextureVertices() == queued.getNumTextureVertices())
+  {
+    for (size_t index = 0u; index < direct.getNumTextureVertices(); ++index)
+    {
+      const ModernUI::TextureVertex& expected = direct.getTextureVertices()[index];
+      const ModernUI::TextureVertex& vertex = queued.getTextureVertices()[index];
+      CHECK(vertex.getX() == expected.getX() && vertex.getY() == expected.getY());
+    }
+  }
+}
+
+// Once the queue held as many changes as are queued between two frames, queueing them takes commands from its pool
+// instead of allocating
+void checkPool(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  CountingResource resource;
+  {
+    ModernUI::Context context(font, &resource);
+    std::vector<ModernUI::ButtonHandle> buttons;
+    for (size_t button = 0u; button < 300u; ++button)
+    {
+      buttons.push_back(context.createButton("Button", static_cast<int32_t>(button), 0, 40, 20));
+    }
+
+    for (size_t frame = 0u; frame < 30u; ++frame)
+    {
+      if (frame == 10u)
+      {
+        resource.numAllocations = 0u;
+      }
+
+      std::thread producer(
+        [&]
+        {
+          for (size_t button = 0u; button < buttons.size(); ++button)
+          {
+            const int32_t position = static_cast<int32_t>((button + frame) % 500u);
+            context.queueButtonPosition(buttons[button], position, position);
+            context.queueButtonText(buttons[button], frame % 2u == 0u ? "Even" : "Odd");
+          }
+        });
+      producer.join();
+      context.processFrame();
+    }
+
+    CHECK(resource.numAllocations == 0u);
+
+    // Commands still in the queue are freed with the context
+    for (size_t change = 0u; change < 1000u; ++change)
+    {
+      context.queueButtonText(buttons.front(), "A label that is too long to fit in place");
+    }
+  }
+}
+} // namespace
+
+int main()
+{
+  const auto font = std::make_shared<const ModernUI::Font>(MODERNUI_TEST_FONT);
+  for (const bool retained : { false, true })
+  {
+    for (const bool threaded : { false, true })
+    {
+      runProducers(font, retained, threaded);
+    }
+  }
+
+  compareSetters(font);
+  checkPool(font);
+  return ModernUI::Test::getResult();
+}
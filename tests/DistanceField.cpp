@@ -0,0 +1,152 @@
+#include "Check.h"
+#include "FontData.h"
+
+#include <modernui/ModernUI.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace
+{
+constexpr int32_t imageWidth = 320;
+constexpr int32_t imageHeight = 200;
+
+// The font texture value at the glyph outline, and one texel of distance
+constexpr float edgeValue = static_cast<float>(ModernUI::distanceFieldEdge) / 255.0f;
+constexpr float texelValue = ModernUI::distanceFieldSteps / 255.0f;
+
+// Pixels of the labels, fully covered ones and partly covered ones at the edges
+struct Coverage final
+{
+  size_t numInside = 0u;
+  size_t numEdge = 0u;
+};
+
+void testShader()
+{
+  CHECK(ModernUI::shadeDistanceField(edgeValue, 1.0f) == 0.5f);
+  CHECK(ModernUI::shadeDistanceField(edgeValue, 4.0f) == 0.5f);
+  CHECK(ModernUI::shadeDistanceField(1.0f, 1.0f) == 1.0f);
+  CHECK(ModernUI::shadeDistanceField(0.0f, 1.0f) == 0.0f);
+
+  // A quarter of a texel is a quarter of a pixel at the baked size, and a whole one at four times of it
+  CHECK(std::fabs(ModernUI::shadeDistanceField(edgeValue + texelValue / 4.0f, 1.0f) - 0.75f) < 1e-5f);
+  CHECK(std::fabs(ModernUI::shadeDistanceField(edgeValue - texelValue / 4.0f, 1.0f) - 0.25f) < 1e-5f);
+  CHECK(ModernUI::shadeDistanceField(edgeValue + texelValue / 4.0f, 4.0f) == 1.0f);
+  CHECK(ModernUI::shadeDistanceField(edgeValue - texelValue / 4.0f, 4.0f) == 0.0f);
+}
+
+// Bilinear and clamped, glyphs are padded so their quads never reach beyond their own texels
+float sample(const unsigned char* texture, float u, float v)
+{
+  constexpr float maxCoordinate = static_cast<float>(ModernUI::fontTextureSize - 1);
+  const float s = std::clamp(u * ModernUI::fontTextureSize - 0.5f, 0.0f, maxCoordinate);
+  const float t = std::clamp(v * ModernUI::fontTextureSize - 0.5f, 0.0f, maxCoordinate);
+  const int32_t x0 = static_cast<int32_t>(s);
+  const int32_t y0 = static_cast<int32_t>(t);
+  const int32_t x1 = std::min(x0 + 1, ModernUI::fontTextureSize - 1);
+  const int32_t y1 = std::min(y0 + 1, ModernUI::fontTextureSize - 1);
+  const float fractionX = s - static_cast<float>(x0);
+  const float fractionY = t - static_cast<float>(y0);
+
+  const float t00 = texture[y0 * ModernUI::fontTextureSize + x0];
+  const float t10 = texture[y0 * ModernUI::fontTextureSize + x1];
+  const float t01 = texture[y1 * ModernUI::fontTextureSize + x0];
+  const float t11 = texture[y1 * ModernUI::fontTextureSize + x1];
+  const float top = t00 + (t10 - t00) * fractionX;
+  const float bottom = t01 + (t11 - t01) * fractionX;
+  return (top + (bottom - top) * fractionY) / 255.0f;
+}
+
+// Shades the center of every pixel of the glyph quads with shadeDistanceField(), the way a fragment shader would
+Coverage render(const std::shared_ptr<const ModernUI::Font>& font, float scale)
+{
+  ModernUI::Context context(font);
+  context.setDistanceFieldText(true);
+  context.setTextScale(scale);
+  context.createButton("Hello", 0, 0, imageWidth, imageHeight);
+  context.processFrame();
+
+  // Every vertex carries the scale, which the compact layout stores in 1/256 steps
+  const ModernUI::TextureVertex* vertices = context.getTextureVertices();
+  const size_t numVertices = context.getNumTextureVertices();
+  CHECK(numVertices > 0u && numVertices % 6u == 0u);
+  for (size_t index = 0u; index < numVertices; ++index)
+  {
+#if defined(MODERNUI_COMPACT_VERTICES)
+    CHECK(std::fabs(vertices[index].getScale() - scale) <= 0.5f / 256.0f);
+#else
+    CHECK(vertices[index].getScale() == scale);
+#endif
+  }
+
+  // Quads are axis aligned, with texture coordinates that grow with the position
+  std::vector<float> image(static_cast<size_t>(imageWidth) * imageHeight, 0.0f);
+  for (size_t first = 0u; first + 6u <= numVertices; first += 6u)
+  {
+    float x0 = vertices[first].getX(), y0 = vertices[first].getY(), x1 = x0, y1 = y0;
+    float u0 = vertices[first].getU(), v0 = vertices[first].getV(), u1 = u0, v1 = v0;
+    for (size_t index = first + 1u; index < first + 6u; ++index)
+    {
+      x0 = std::min(x0, vertices[index].getX());
+      y0 = std::min(y0, vertices[index].getY());
+      x1 = std::max(x1, vertices[index].getX());
+      y1 = std::max(y1, vertices[index].getY());
+      u0 = std::min(u0, vertices[index].getU());
+      v0 = std::min(v0, vertices[index].getV());
+      u1 = std::max(u1, vertices[index].getU());
+      v1 = std::max(v1, vertices[index].getV());
+    }
+
+    const int32_t top = std::max(0, static_cast<int32_t>(y0));
+    const int32_t bottom = std::min(imageHeight, static_cast<int32_t>(y1));
+    const int32_t left = std::max(0, static_cast<int32_t>(x0));
+    const int32_t right = std::min(imageWidth, static_cast<int32_t>(x1));
+    for (int32_t y = top; y < bottom; ++y)
+    {
+      for (int32_t x = left; x < right; ++x)
+      {
+        const float u = u0 + (u1 - u0) * (static_cast<float>(x) + 0.5f - x0) / (x1 - x0);
+        const float v = v0 + (v1 - v0) * (static_cast<float>(y) + 0.5f - y0) / (y1 - y0);
+        const float alpha = ModernUI::shadeDistanceField(sample(context.getFontTextureData(), u, v), scale);
+        float& pixel = image[static_cast<size_t>(y) * imageWidth + x];
+        pixel = std::max(pixel, alpha);
+      }
+    }
+  }
+
+  Coverage coverage;
+  for (const float alpha : image)
+  {
+    coverage.numInside += alpha == 1.0f ? 1u : 0u;
+    coverage.numEdge += alpha > 0.0f && alpha < 1.0f ? 1u : 0u;
+  }
+
+  return coverage;
+}
+} // namespace
+
+int main()
+{
+  const auto font = std::make_shared<const ModernUI::Font>(MODERNUI_TEST_FONT);
+  testShader();
+
+  // Distance fields keep the edges about a pixel wide at any scale, so the edge grows with the outline while the area
+  // grows with its square. Stretched coverage would blur the edges by the scale instead.
+  const Coverage baked = render(font, 1.0f);
+  CHECK(baked.numInside > 0u && baked.numEdge > 0u);
+  for (const float scale : { 1.3f, 2.0f, 3.0f, 4.0f })
+  {
+    const Coverage scaled = render(font, scale);
+    const float edgeRatio = static_cast<float>(scaled.numEdge) / static_cast<float>(baked.numEdge);
+    const float areaRatio = static_cast<float>(scaled.numInside + scaled.numEdge) /
+                            static_cast<float>(baked.numInside + baked.numEdge);
+    CHECK(edgeRatio > scale * 0.7f && edgeRatio < scale * 1.3f);
+    CHECK(areaRatio > scale * scale * 0.5f && areaRatio < scale * scale * 1.5f);
+    CHECK(scaled.numInside * baked.numEdge > baked.numInside * scaled.numEdge);
+  }
+
+  return ModernUI::Test::getResult();
+}
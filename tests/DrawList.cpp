@@ -0,0 +1,230 @@
+#include "Check.h"
+
+#include <modernui/ModernUI.h>
+#include <modernui/Rasterizer.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int32_t imageWidth = 320;
+constexpr int32_t imageHeight = 200;
+constexpr uint32_t white = 0xffffffffu;
+constexpr uint32_t blue = 0xffff0000u;
+
+using Pipeline = ModernUI::DrawCommand::Pipeline;
+
+std::vector<Pipeline> getPipelines(const ModernUI::Context& context)
+{
+  std::vector<Pipeline> pipelines;
+  for (size_t index = 0u; index < context.getNumDrawCommands(); ++index)
+  {
+    pipelines.push_back(context.getDrawCommands()[index].pipeline);
+  }
+
+  return pipelines;
+}
+
+std::vector<uint32_t> render(const ModernUI::Context& context)
+{
+  ModernUI::Rasterizer rasterizer(imageWidth, imageHeight);
+  rasterizer.clear(0.0f, 0.0f, 0.0f);
+  rasterizer.draw(context);
+  return std::vector<uint32_t>(rasterizer.getPixels(), rasterizer.getPixels() + imageWidth * imageHeight);
+}
+
+// Whether every pixel of the rect has the color
+bool isFilled(const std::vector<uint32_t>& image, const ModernUI::Rect& rect, uint32_t color)
+{
+  for (int32_t y = rect.y; y < rect.y + rect.height; ++y)
+  {
+    for (int32_t x = rect.x; x < rect.x + rect.width; ++x)
+    {
+      if (image[static_cast<size_t>(y) * imageWidth + x] != color)
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Widgets that do not overlap are all in the first layer, so all boxes and then all labels are drawn at once
+void testBatches(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  ModernUI::Context context(font);
+  context.setDrawList(true);
+  for (int32_t index = 0; index < 20; ++index)
+  {
+    context.createButton("Button", index % 5 * 100, index / 5 * 30, 90, 20);
+  }
+
+  context.processFrame();
+  CHECK(getPipelines(context) == std::vector<Pipeline>({ Pipeline::Color, Pipeline::Text }));
+  CHECK(context.getDrawCommands()[0].count == context.getNumColorVertices());
+  CHECK(context.getDrawCommands()[1].count == context.getNumTextureVertices());
+
+  // Buttons inside of windows are one layer up, but their boxes follow the windows in the stream and still merge
+  ModernUI::Context nested(font);
+  nested.setDrawList(true);
+  for (int32_t index = 0; index < 20; ++index)
+  {
+    nested.createWindow(index % 5 * 100, index / 5 * 30, 90, 28);
+    nested.createButton("Inside", index % 5 * 100 + 5, index / 5 * 30 + 4, 80, 20);
+  }
+
+  nested.processFrame();
+  CHECK(getPipelines(nested) == std::vector<Pipeline>({ Pipeline::Color, Pipeline::Text }));
+  CHECK(nested.getDrawCommands()[0].layer == 0u);
+  CHECK(nested.getDrawCommands()[1].layer == 1u);
+
+  // Every label of a cascade of buttons has to be drawn before the next box
+  ModernUI::Context cascade(font);
+  cascade.setDrawList(true);
+  for (int32_t index = 0; index < 5; ++index)
+  {
+    cascade.createButton("Cascade", index * 10, index * 10, 80, 20);
+  }
+
+  cascade.processFrame();
+  std::vector<Pipeline> expected;
+  for (int32_t index = 0; index < 5; ++index)
+  {
+    expected.push_back(Pipeline::Color);
+    expected.push_back(Pipeline::Text);
+  }
+
+  CHECK(getPipelines(cascade) == expected);
+  for (size_t index = 0u; index < cascade.getNumDrawCommands(); ++index)
+  {
+    CHECK(cascade.getDrawCommands()[index].layer == index / 2u);
+  }
+}
+
+// Random scenes, where the commands have to be sorted by layer and draw every vertex exactly once
+void testRandomScenes(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  std::mt19937 random(23u);
+  for (size_t scene = 0u; scene < 20u; ++scene)
+  {
+    ModernUI::Context context(font);
+    context.setDrawList(true);
+    for (size_t index = 0u; index < 200u; ++index)
+    {
+      const int32_t x = static_cast<int32_t>(random() % 1000u);
+      const int32_t y = static_cast<int32_t>(random() % 1000u);
+      if (random() % 2u)
+      {
+        const int32_t width = 10 + static_cast<int32_t>(random() % 200u);
+        const int32_t height = 10 + static_cast<int32_t>(random() % 200u);
+        context.createWindow(x, y, width, height);
+      }
+      else
+      {
+        context.createButton("Label", x, y, 60, 20);
+      }
+    }
+
+    context.processFrame();
+
+    std::vector<unsigned char> colorVertices(context.getNumColorVertices(), 0u);
+    std::vector<unsigned char> textureVertices(context.getNumTextureVertices(), 0u);
+    for (size_t index = 0u; index < context.getNumDrawCommands(); ++index)
+    {
+      const ModernUI::DrawCommand& command = context.getDrawCommands()[index];
+      if (index > 0u)
+      {
+        CHECK(command.layer >= context.getDrawCommands()[index - 1u].layer);
+      }
+
+      std::vector<unsigned char>& drawn = command.pipeline == Pipeline::Text ? textureVertices : colorVertices;
+      CHECK(command.pipeline != Pipeline::Rectangle);
+      CHECK(command.first + command.count <= drawn.size());
+      for (size_t vertex = command.first; vertex < command.first + command.count && vertex < drawn.size(); ++vertex)
+      {
+        ++drawn[vertex];
+      }
+    }
+
+    CHECK(std::vector<unsigned char>(colorVertices.size(), 1u) == colorVertices);
+    CHECK(std::vector<unsigned char>(textureVertices.size(), 1u) == textureVertices);
+  }
+}
+
+// Two windows, a button with a label on top of them and a second button without a label over that label
+void testStacking(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  const ModernUI::Rect lowerWindow = { 0, 0, 200, 100 };
+  const ModernUI::Rect upperWindow = { 100, 50, 200, 100 };
+  const ModernUI::Rect lowerButton = { 20, 20, 150, 40 };
+  const ModernUI::Rect upperButton = { 60, 30, 150, 40 };
+
+  // A child of the lower window that the upper window covers, relative to its parent
+  const ModernUI::Rect childButton = { 150, 70, 40, 25 };
+
+  const auto createScene = [&](ModernUI::Context& context) {
+    const ModernUI::WindowHandle lower =
+      context.createWindow(lowerWindow.x, lowerWindow.y, lowerWindow.width, lowerWindow.height);
+    const ModernUI::WindowHandle upper =
+      context.createWindow(upperWindow.x, upperWindow.y, upperWindow.width, upperWindow.height);
+    context.setWindowColor(lower, 1.0f, 0.0f, 0.0f);
+    context.setWindowColor(upper, 0.0f, 0.0f, 1.0f);
+    context.createButton("WWWWWWWWWWWW", lowerButton.x, lowerButton.y, lowerButton.width, lowerButton.height);
+    context.createButton("", upperButton.x, upperButton.y, upperButton.width, upperButton.height);
+    const ModernUI::ButtonHandle child =
+      context.createButton("", childButton.x, childButton.y, childButton.width, childButton.height);
+    context.setParent(child, lower);
+    context.processFrame();
+  };
+
+  // Drawing the streams one after the other puts the lower label on top of the upper button
+  ModernUI::Context streams(font);
+  createScene(streams);
+  CHECK(!isFilled(render(streams), upperButton, white));
+
+  ModernUI::Context context(font);
+  context.setDrawList(true);
+  createScene(context);
+  CHECK(getPipelines(context) ==
+        std::vector<Pipeline>({ Pipeline::Color, Pipeline::Color, Pipeline::Color, Pipeline::Text, Pipeline::Color }));
+
+  const std::vector<uint32_t> image = render(context);
+  CHECK(isFilled(image, upperButton, white));
+  CHECK(isFilled(image, { 210, 60, 90, 90 }, blue));
+  CHECK(isFilled(image, { lowerWindow.x + childButton.x, lowerWindow.y + childButton.y, childButton.width,
+                          childButton.height }, blue));
+  CHECK(!isFilled(image, { lowerButton.x, lowerButton.y, upperButton.x - lowerButton.x, lowerButton.height }, white));
+
+  // Every output mode draws the same image
+  for (const bool retained : { false, true })
+  {
+    for (const bool instanced : { false, true })
+    {
+      for (const ModernUI::Context::IndexType indexType : { ModernUI::Context::IndexType::None,
+                                                            ModernUI::Context::IndexType::UInt16,
+                                                            ModernUI::Context::IndexType::UInt32 })
+      {
+        ModernUI::Context other(font);
+        other.setDrawList(true);
+        other.setRetainedMode(retained);
+        other.setInstancedRectangles(instanced);
+        other.setIndexType(indexType);
+        createScene(other);
+        CHECK(render(other) == image);
+      }
+    }
+  }
+}
+} // namespace
+
+int main()
+{
+  const auto font = std::make_shared<const ModernUI::Font>(MODERNUI_TEST_FONT);
+  testBatches(font);
+  testRandomScenes(font);
+  testStacking(font);
+  return ModernUI::Test::getResult();
+}
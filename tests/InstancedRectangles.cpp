@@ -0,0 +1,115 @@
+#include "Check.h"
+
+#include <modernui/ModernUI.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Instances pack their color as RGBA8, which float vertices only match after rounding
+constexpr float colorTolerance = 0.5f / 255.0f + 1.0e-6f;
+
+bool isClose(float a, float b)
+{
+  return std::fabs(a - b) <= colorTolerance;
+}
+
+// Expands the instances of one context and compares them to the color vertices of the other, triangle by triangle
+void compare(const ModernUI::Context& vertexContext, const ModernUI::Context& instanceContext)
+{
+  const size_t numInstances = instanceContext.getNumRectangleInstances();
+  std::vector<ModernUI::ColorVertex> expanded(numInstances * 6u);
+  ModernUI::expandRectangleInstances(instanceContext.getRectangleInstances(), numInstances, expanded.data());
+
+  CHECK(instanceContext.getNumColorVertices() == 0u);
+  CHECK(expanded.size() == vertexContext.getNumColorVertices());
+  if (expanded.size() != vertexContext.getNumColorVertices())
+  {
+    return;
+  }
+
+  for (size_t index = 0u; index < expanded.size(); ++index)
+  {
+    const ModernUI::ColorVertex& a = vertexContext.getColorVertices()[index];
+    const ModernUI::ColorVertex& b = expanded[index];
+    CHECK(a.getX() == b.getX());
+    CHECK(a.getY() == b.getY());
+    CHECK(isClose(a.getR(), b.getR()));
+    CHECK(isClose(a.getG(), b.getG()));
+    CHECK(isClose(a.getB(), b.getB()));
+  }
+}
+
+// Random windows and buttons that are created, changed and destroyed in the same way in both contexts
+void runScene(const std::shared_ptr<const ModernUI::Font>& font, bool retained)
+{
+  ModernUI::Context vertexContext(font);
+  ModernUI::Context instanceContext(font);
+  instanceContext.setInstancedRectangles(true);
+  vertexContext.setRetainedMode(retained);
+  instanceContext.setRetainedMode(retained);
+
+  std::mt19937 random(retained ? 2u : 1u);
+  const auto getCoordinate = [&random]() { return static_cast<int32_t>(random() % 1000u); };
+  const auto getColor = [&random]() { return static_cast<float>(random() % 1001u) / 1000.0f; };
+
+  std::vector<std::pair<ModernUI::WindowHandle, ModernUI::WindowHandle>> windows;
+  std::vector<std::pair<ModernUI::ButtonHandle, ModernUI::ButtonHandle>> buttons;
+  for (size_t frame = 0u; frame < 50u; ++frame)
+  {
+    for (size_t change = 0u; change < 20u; ++change)
+    {
+      const uint32_t action = random() % 5u;
+      const int32_t x = getCoordinate(), y = getCoordinate();
+      if (action == 0u || windows.empty())
+      {
+        windows.push_back({ vertexContext.createWindow(x, y, 40, 30), instanceContext.createWindow(x, y, 40, 30) });
+      }
+      else if (action == 1u)
+      {
+        const auto& window = windows[random() % windows.size()];
+        const float r = getColor(), g = getColor(), b = getColor();
+        vertexContext.setWindowColor(window.first, r, g, b);
+        instanceContext.setWindowColor(window.second, r, g, b);
+        vertexContext.setWindowPosition(window.first, x, y);
+        instanceContext.setWindowPosition(window.second, x, y);
+      }
+      else if (action == 2u)
+      {
+        const size_t index = random() % windows.size();
+        vertexContext.destroyWindow(windows[index].first);
+        instanceContext.destroyWindow(windows[index].second);
+        windows.erase(windows.begin() + index);
+      }
+      else if (action == 3u || buttons.empty())
+      {
+        buttons.push_back(
+          { vertexContext.createButton("Button", x, y, 60, 20), instanceContext.createButton("Button", x, y, 60, 20) });
+      }
+      else
+      {
+        const auto& button = buttons[random() % buttons.size()];
+        vertexContext.setButtonSize(button.first, x / 10, y / 10);
+        instanceContext.setButtonSize(button.second, x / 10, y / 10);
+      }
+    }
+
+    vertexContext.processFrame();
+    instanceContext.processFrame();
+    compare(vertexContext, instanceContext);
+  }
+}
+} // namespace
+
+int main()
+{
+  const auto font = std::make_shared<const ModernUI::Font>(MODERNUI_TEST_FONT);
+  CHECK(font->getError() == ModernUI::Context::Error::Success);
+
+  runScene(font, false);
+  runScene(font, true);
+  return ModernUI::Test::getResult();
+}
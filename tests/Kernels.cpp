@@ -0,0 +1,131 @@
+#include "Check.h"
+
+#include "Kernels.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr size_t maxCount = 70u;
+constexpr unsigned char guardByte = 0xcd;
+
+// Inputs and outputs start a few bytes into their buffers, so that vector kernels see every alignment, and end with
+// guard bytes that must stay untouched
+template<typename T>
+T* getOffsetPointer(std::vector<unsigned char>& buffer, size_t offset)
+{
+  return reinterpret_cast<T*>(buffer.data() + offset);
+}
+
+float getFloat(std::mt19937& random)
+{
+  // Also whole numbers, negative zero and values that do not fit into 16 bits
+  const uint32_t kind = random() % 4u;
+  if (kind == 0u)
+  {
+    return static_cast<float>(static_cast<int32_t>(random() % 2001u) - 1000);
+  }
+  else if (kind == 1u)
+  {
+    return -0.0f;
+  }
+  else if (kind == 2u)
+  {
+    return static_cast<float>(static_cast<int32_t>(random())) * 0.001f;
+  }
+
+  return std::uniform_real_distribution<float>(-1.0f, 1.0f)(random);
+}
+
+void testRectangles(ModernUI::Context::InstructionSet set, bool indexed, std::mt19937& random)
+{
+  const ModernUI::Kernels& scalar = ModernUI::getKernels(ModernUI::Context::InstructionSet::Scalar);
+  const ModernUI::Kernels& kernels = ModernUI::getKernels(set);
+  const auto expandScalar = indexed ? scalar.expandIndexedRectangles : scalar.expandRectangles;
+  const auto expand = indexed ? kernels.expandIndexedRectangles : kernels.expandRectangles;
+  const size_t verticesPerRectangle = indexed ? 4u : 6u;
+
+  for (size_t count = 0u; count <= maxCount; ++count)
+  {
+    for (size_t offset = 0u; offset < 32u; offset += 4u)
+    {
+      std::vector<unsigned char> input(offset + count * sizeof(ModernUI::RectangleInput));
+      ModernUI::RectangleInput* rectangles = getOffsetPointer<ModernUI::RectangleInput>(input, offset);
+      for (size_t index = 0u; index < count; ++index)
+      {
+        // Coordinates are converted to float, which has to round the same way everywhere
+        ModernUI::RectangleInput& rectangle = rectangles[index];
+        rectangle.x = static_cast<int32_t>(random());
+        rectangle.y = static_cast<int32_t>(random() % 4001u) - 2000;
+        rectangle.width = static_cast<int32_t>(random() % 2u ? random() : random() % 1000u);
+        rectangle.height = static_cast<int32_t>(random() % 1000u);
+        rectangle.r = getFloat(random);
+        rectangle.g = getFloat(random);
+        rectangle.b = getFloat(random);
+        rectangle.padding = getFloat(random);
+      }
+
+      const size_t outputSize = count * verticesPerRectangle * sizeof(ModernUI::ColorVertex);
+      std::vector<unsigned char> expected(offset + outputSize + 64u, guardByte);
+      std::vector<unsigned char> actual(offset + outputSize + 64u, guardByte);
+      expandScalar(rectangles, count, getOffsetPointer<ModernUI::ColorVertex>(expected, offset));
+      expand(rectangles, count, getOffsetPointer<ModernUI::ColorVertex>(actual, offset));
+      CHECK(std::memcmp(expected.data(), actual.data(), actual.size()) == 0);
+    }
+  }
+}
+
+void testTextureVertices(ModernUI::Context::InstructionSet set, std::mt19937& random)
+{
+  const ModernUI::Kernels& scalar = ModernUI::getKernels(ModernUI::Context::InstructionSet::Scalar);
+  const ModernUI::Kernels& kernels = ModernUI::getKernels(set);
+
+  for (size_t count = 0u; count <= maxCount; ++count)
+  {
+    for (size_t offset = 0u; offset < 32u; offset += 4u)
+    {
+      std::vector<unsigned char> input(offset + count * sizeof(ModernUI::TextureVertex));
+      ModernUI::TextureVertex* vertices = getOffsetPointer<ModernUI::TextureVertex>(input, offset);
+      std::uniform_real_distribution<float> coordinates(0.0f, 1.0f);
+      for (size_t index = 0u; index < count; ++index)
+      {
+        vertices[index] = { getFloat(random), getFloat(random), coordinates(random), coordinates(random),
+                            getFloat(random) };
+      }
+
+      const float x = getFloat(random);
+      const float y = getFloat(random);
+      const size_t outputSize = count * sizeof(ModernUI::TextureVertex);
+      std::vector<unsigned char> expected(offset + outputSize + 64u, guardByte);
+      std::vector<unsigned char> actual(offset + outputSize + 64u, guardByte);
+      scalar.translateTextureVertices(vertices, count, x, y,
+                                      getOffsetPointer<ModernUI::TextureVertex>(expected, offset));
+      kernels.translateTextureVertices(vertices, count, x, y,
+                                       getOffsetPointer<ModernUI::TextureVertex>(actual, offset));
+      CHECK(std::memcmp(expected.data(), actual.data(), actual.size()) == 0);
+    }
+  }
+}
+} // namespace
+
+int main()
+{
+  std::mt19937 random(8u);
+  for (const ModernUI::Context::InstructionSet set : { ModernUI::Context::InstructionSet::Scalar,
+                                                       ModernUI::Context::InstructionSet::SSE2,
+                                                       ModernUI::Context::InstructionSet::AVX2 })
+  {
+    if (!ModernUI::isInstructionSetSupported(set))
+    {
+      continue;
+    }
+
+    testRectangles(set, false, random);
+    testRectangles(set, true, random);
+    testTextureVertices(set, random);
+  }
+
+  return ModernUI::Test::getResult();
+}
@@ -0,0 +1,222 @@
+#include "Check.h"
+
+#include <modernui/ModernUI.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+constexpr size_t numSlots = 3u;
+constexpr size_t slotCapacity = 16384u;
+
+struct Memory final
+{
+  std::vector<ModernUI::ColorVertex> colorVertices;
+  std::vector<ModernUI::TextureVertex> textureVertices;
+  std::vector<ModernUI::RectangleInstance> rectangleInstances;
+  ModernUI::OutputBuffers buffers;
+
+  explicit Memory(size_t capacity)
+  : colorVertices(capacity), textureVertices(capacity), rectangleInstances(capacity)
+  {
+    // Garbage that a partial rewrite would leave behind
+    std::memset(colorVertices.data(), 0xcd, capacity * sizeof(ModernUI::ColorVertex));
+    std::memset(textureVertices.data(), 0xcd, capacity * sizeof(ModernUI::TextureVertex));
+    std::memset(rectangleInstances.data(), 0xcd, capacity * sizeof(ModernUI::RectangleInstance));
+
+    buffers.colorVertices = colorVertices.data();
+    buffers.colorVertexCapacity = capacity;
+    buffers.textureVertices = textureVertices.data();
+    buffers.textureVertexCapacity = capacity;
+    buffers.rectangleInstances = rectangleInstances.data();
+    buffers.rectangleInstanceCapacity = capacity;
+  }
+};
+
+template<typename T>
+bool isEqual(const T* a, const T* b, size_t numElements)
+{
+  return numElements == 0u || std::memcmp(a, b, numElements * sizeof(T)) == 0;
+}
+
+// The output of a context that writes into its own vectors
+bool isEqual(const ModernUI::Context& context, const ModernUI::Context& reference)
+{
+  return context.getNumColorVertices() == reference.getNumColorVertices() &&
+         context.getNumTextureVertices() == reference.getNumTextureVertices() &&
+         isEqual(context.getColorVertices(), reference.getColorVertices(), reference.getNumColorVertices()) &&
+         isEqual(context.getTextureVertices(), reference.getTextureVertices(), reference.getNumTextureVertices());
+}
+
+size_t getNumRewrittenBytes(const ModernUI::Context& context)
+{
+  size_t numBytes = 0u;
+  for (size_t index = 0u; index < context.getNumColorVertexRanges(); ++index)
+  {
+    numBytes += context.getColorVertexRanges()[index].size;
+  }
+
+  for (size_t index = 0u; index < context.getNumTextureVertexRanges(); ++index)
+  {
+    numBytes += context.getTextureVertexRanges()[index].size;
+  }
+
+  return numBytes;
+}
+
+void testWraparound()
+{
+  Memory memory(numSlots * slotCapacity);
+  memory.buffers.rectangleInstances = nullptr;
+  memory.buffers.rectangleInstanceCapacity = 0u;
+  ModernUI::OutputRing ring(memory.buffers, numSlots);
+  CHECK(ring.getNumSlots() == numSlots);
+
+  // Every slot can be in flight once, then the oldest frame has to be released first
+  for (size_t frame = 0u; frame < numSlots; ++frame)
+  {
+    CHECK(ring.acquire());
+    CHECK(ring.getSlot() == frame);
+  }
+
+  CHECK(ring.getNumFramesInFlight() == numSlots);
+  CHECK(!ring.acquire());
+  CHECK(ring.getSlot() == numSlots - 1u);
+
+  // Frames two behind are released, like a renderer that waits on the fence of the frame before last
+  for (size_t frame = numSlots; frame < 10u * numSlots; ++frame)
+  {
+    ring.release();
+    CHECK(ring.acquire());
+    CHECK(ring.getSlot() == frame % numSlots);
+    CHECK(ring.getNumFramesInFlight() == numSlots);
+
+    const ModernUI::OutputBuffers buffers = ring.getBuffers();
+    CHECK(buffers.colorVertices == memory.colorVertices.data() + ring.getSlot() * slotCapacity);
+    CHECK(buffers.colorVertexCapacity == slotCapacity);
+    CHECK(buffers.textureVertices == memory.textureVertices.data() + ring.getSlot() * slotCapacity);
+    CHECK(buffers.textureVertexCapacity == slotCapacity);
+    CHECK(buffers.rectangleInstances == nullptr);
+    CHECK(buffers.rectangleInstanceCapacity == 0u);
+  }
+
+  for (size_t frame = 0u; frame < numSlots; ++frame)
+  {
+    ring.release();
+  }
+
+  CHECK(ring.getNumFramesInFlight() == 0u);
+  ring.release();
+  CHECK(ring.getNumFramesInFlight() == 0u);
+}
+
+void addWidgets(ModernUI::Context& context, size_t numWidgets)
+{
+  for (size_t index = 0u; index < numWidgets; ++index)
+  {
+    const int32_t x = static_cast<int32_t>(index % 10u) * 50;
+    const int32_t y = static_cast<int32_t>(index / 10u) * 30;
+    context.createWindow(x, y, 48, 28);
+    context.createButton("Label", x + 2, y + 2, 44, 24);
+  }
+}
+
+void testOverflow(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  ModernUI::Context reference(font);
+  ModernUI::Context context(font);
+  addWidgets(reference, 100u);
+  addWidgets(context, 100u);
+  reference.processFrame();
+
+  // Too small for the frame, which is then written into the context
+  Memory small(16u);
+  context.setOutputBuffers(small.buffers);
+  context.processFrame();
+  CHECK(context.hasOutputOverflow());
+  CHECK(context.getColorVertices() != small.colorVertices.data());
+  CHECK(context.getTextureVertices() != small.textureVertices.data());
+  CHECK(isEqual(context, reference));
+
+  // The reported sizes are what the next buffers need
+  Memory large(std::max(context.getNumColorVertices(), context.getNumTextureVertices()));
+  context.setOutputBuffers(large.buffers);
+  context.processFrame();
+  CHECK(!context.hasOutputOverflow());
+  CHECK(context.getColorVertices() == large.colorVertices.data());
+  CHECK(context.getTextureVertices() == large.textureVertices.data());
+  CHECK(isEqual(context, reference));
+
+  context.clearOutputBuffers();
+  context.processFrame();
+  CHECK(!context.hasOutputOverflow());
+  CHECK(context.getColorVertices() != large.colorVertices.data());
+  CHECK(isEqual(context, reference));
+}
+
+void testRetainedRewrite(const std::shared_ptr<const ModernUI::Font>& font)
+{
+  ModernUI::Context reference(font);
+  ModernUI::Context context(font);
+  reference.setRetainedMode(true);
+  context.setRetainedMode(true);
+  addWidgets(reference, 100u);
+  addWidgets(context, 100u);
+  const ModernUI::ButtonHandle referenceButton = reference.createButton("Moving", 0, 400, 60, 20);
+  const ModernUI::ButtonHandle button = context.createButton("Moving", 0, 400, 60, 20);
+
+  Memory memory(numSlots * slotCapacity);
+  ModernUI::OutputRing ring(memory.buffers, numSlots);
+  for (size_t frame = 0u; frame < 10u; ++frame)
+  {
+    reference.setButtonPosition(referenceButton, static_cast<int32_t>(frame), 400);
+    context.setButtonPosition(button, static_cast<int32_t>(frame), 400);
+
+    // Every frame goes to the next slot, whose contents are a few frames old
+    if (!ring.acquire())
+    {
+      ring.release();
+      ring.acquire();
+    }
+
+    context.setOutputBuffers(ring.getBuffers());
+    reference.processFrame();
+    context.processFrame();
+    CHECK(!context.hasOutputOverflow());
+    CHECK(context.getColorVertices() == ring.getBuffers().colorVertices);
+    CHECK(isEqual(context, reference));
+
+    const size_t numBytes = context.getNumColorVertices() * sizeof(ModernUI::ColorVertex) +
+                            context.getNumTextureVertices() * sizeof(ModernUI::TextureVertex);
+    CHECK(getNumRewrittenBytes(context) == numBytes);
+  }
+
+  // The same buffers again only get the changed ranges
+  Memory single(slotCapacity);
+  context.setOutputBuffers(single.buffers);
+  context.processFrame();
+  reference.processFrame();
+  for (size_t frame = 0u; frame < 10u; ++frame)
+  {
+    reference.setButtonPosition(referenceButton, static_cast<int32_t>(frame), 420);
+    context.setButtonPosition(button, static_cast<int32_t>(frame), 420);
+    context.setOutputBuffers(single.buffers);
+    reference.processFrame();
+    context.processFrame();
+    CHECK(isEqual(context, reference));
+    CHECK(getNumRewrittenBytes(context) > 0u);
+    CHECK(getNumRewrittenBytes(context) < context.getNumColorVertices() * sizeof(ModernUI::ColorVertex));
+  }
+}
+} // namespace
+
+int main()
+{
+  const auto font = std::make_shared<const ModernUI::Font>(MODERNUI_TEST_FONT);
+  testWraparound();
+  testOverflow(font);
+  testRetainedRewrite(font);
+  return ModernUI::Test::getResult();
+}
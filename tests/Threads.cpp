@@ -0,0 +1,162 @@
+#include "Check.h"
+
+#include <modernui/ModernUI.h>
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr size_t numContexts = 4u;
+
+// Everything a frame outputs, as bytes
+struct Output final
+{
+  std::vector<unsigned char> colorVertices, textureVertices, rectangleInstances;
+  std::vector<size_t> ranges;
+};
+
+template<typename T>
+void append(std::vector<unsigned char>& bytes, const T* elements, size_t numElements)
+{
+  const unsigned char* begin = reinterpret_cast<const unsigned char*>(elements);
+  bytes.insert(bytes.end(), begin, begin + numElements * sizeof(T));
+}
+
+void appendRanges(std::vector<size_t>& ranges, const ModernUI::ByteRange* byteRanges, size_t numByteRanges)
+{
+  ranges.push_back(numByteRanges);
+  for (size_t index = 0u; index < numByteRanges; ++index)
+  {
+    ranges.push_back(byteRanges[index].offset);
+    ranges.push_back(byteRanges[index].size);
+  }
+}
+
+Output getOutput(const ModernUI::Context& context)
+{
+  Output output;
+  append(output.colorVertices, context.getColorVertices(), context.getNumColorVertices());
+  append(output.textureVertices, context.getTextureVertices(), context.getNumTextureVertices());
+  append(output.rectangleInstances, context.getRectangleInstances(), context.getNumRectangleInstances());
+  appendRanges(output.ranges, context.getColorVertexRanges(), context.getNumColorVertexRanges());
+  appendRanges(output.ranges, context.getTextureVertexRanges(), context.getNumTextureVertexRanges());
+  appendRanges(output.ranges, context.getRectangleInstanceRanges(), context.getNumRectangleInstanceRanges());
+  return output;
+}
+
+// Runs every task on a thread of its own, in reverse order, the way a job system might
+void runTasks(size_t numTasks, const std::function<void(size_t task)>& task)
+{
+  std::vector<std::thread> threads;
+  for (size_t index = numTasks; index-- > 0u;)
+  {
+    threads.emplace_back(task, index);
+  }
+
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+// The same changes are made in a context that runs on the calling thread, in two with worker threads and in one with a
+// task executor, and every frame has to come out the same, byte for byte
+void runScene(const std::shared_ptr<const ModernUI::Font>& font, bool retained, bool indexed, bool instanced)
+{
+  std::vector<std::unique_ptr<ModernUI::Context>> contexts;
+  for (size_t index = 0u; index < numContexts; ++index)
+  {
+    contexts.push_back(std::make_unique<ModernUI::Context>(font));
+    ModernUI::Context& context = *contexts.back();
+    context.setRetainedMode(retained);
+    context.setIndexType(indexed ? ModernUI::Context::IndexType::UInt16 : ModernUI::Context::IndexType::None);
+    context.setInstancedRectangles(instanced);
+    context.setDynamicGlyphs(indexed);
+  }
+
+  contexts[1]->setNumThreads(3u);
+  contexts[2]->setNumThreads(8u);
+  contexts[3]->setTaskExecutor(runTasks);
+
+  std::mt19937 random(static_cast<uint32_t>(retained) | static_cast<uint32_t>(indexed) << 1u |
+                      static_cast<uint32_t>(instanced) << 2u);
+  std::vector<std::vector<ModernUI::WindowHandle>> windows(numContexts);
+  std::vector<std::vector<ModernUI::ButtonHandle>> buttons(numContexts);
+  for (size_t frame = 0u; frame < 20u; ++frame)
+  {
+    // Enough widgets for many chunks at first, then a few changes per frame
+    const size_t numChanges = frame == 0u ? 10000u : 300u;
+    for (size_t change = 0u; change < numChanges; ++change)
+    {
+      const uint32_t action = random() % 5u;
+      const int32_t x = static_cast<int32_t>(random() % 1000u);
+      const int32_t y = static_cast<int32_t>(random() % 1000u);
+      const std::string text(random() % 12u, static_cast<char>('A' + random() % 26u));
+      const size_t window = windows[0].empty() ? 0u : random() % windows[0].size();
+      const size_t button = buttons[0].empty() ? 0u : random() % buttons[0].size();
+      for (size_t index = 0u; index < numContexts; ++index)
+      {
+        ModernUI::Context& context = *contexts[index];
+        if (action == 0u)
+        {
+          windows[index].push_back(context.createWindow(x, y, 20, 10));
+        }
+        else if (action == 1u)
+        {
+          buttons[index].push_back(context.createButton(text, x, y, 40, 20));
+        }
+        else if (action == 2u && !windows[index].empty())
+        {
+          context.destroyWindow(windows[index][window]);
+          windows[index].erase(windows[index].begin() + window);
+        }
+        else if (action == 3u && !buttons[index].empty())
+        {
+          context.setButtonText(buttons[index][button], text);
+          context.setButtonPosition(buttons[index][button], x, y);
+        }
+        else if (action == 4u && !buttons[index].empty())
+        {
+          context.destroyButton(buttons[index][button]);
+          buttons[index].erase(buttons[index].begin() + button);
+        }
+      }
+    }
+
+    contexts[0]->processFrame();
+    const Output expected = getOutput(*contexts[0]);
+    for (size_t index = 1u; index < numContexts; ++index)
+    {
+      contexts[index]->processFrame();
+      const Output output = getOutput(*contexts[index]);
+      CHECK(output.colorVertices == expected.colorVertices);
+      CHECK(output.textureVertices == expected.textureVertices);
+      CHECK(output.rectangleInstances == expected.rectangleInstances);
+      CHECK(output.ranges == expected.ranges);
+    }
+  }
+}
+} // namespace
+
+int main()
+{
+  const auto font = std::make_shared<const ModernUI::Font>(MODERNUI_TEST_FONT);
+  for (const bool retained : { false, true })
+  {
+    for (const bool indexed : { false, true })
+    {
+      for (const bool instanced : { false, true })
+      {
+        runScene(font, retained, indexed, instanced);
+      }
+    }
+  }
+
+  return ModernUI::Test::getResult();
+}